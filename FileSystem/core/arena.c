@@ -0,0 +1,103 @@
+/** @author yaishenka
+    @date 19.10.2026 */
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include "arena.h"
+
+#define ARENA_CHUNK_SIZE (64 * 1024)
+#define ARENA_ALIGNMENT _Alignof(max_align_t)
+
+/**
+ * @brief Chunk of arena
+ * Chunks are linked from newest to oldest, newest chunk is the largest one
+ */
+struct arena_chunk {
+  struct arena_chunk* next;
+  size_t capacity;
+  size_t used;
+  _Alignas(max_align_t) char data[];
+};
+
+static _Thread_local struct arena_chunk* arena_head = NULL;
+
+static size_t align_size(size_t size) {
+  return (size + ARENA_ALIGNMENT - 1) & ~(ARENA_ALIGNMENT - 1);
+}
+
+static struct arena_chunk* push_arena_chunk(size_t min_capacity) {
+  size_t capacity = arena_head == NULL ? ARENA_CHUNK_SIZE
+                                       : 2 * arena_head->capacity;
+  while (capacity < min_capacity) {
+    capacity *= 2;
+  }
+
+  struct arena_chunk* chunk =
+      (struct arena_chunk*) malloc(sizeof(struct arena_chunk) + capacity);
+  if (chunk == NULL) {
+    fprintf(stderr, "Can't allocate arena chunk. Abort!\n");
+    exit(EXIT_FAILURE);
+  }
+
+  chunk->next = arena_head;
+  chunk->capacity = capacity;
+  chunk->used = 0;
+  arena_head = chunk;
+  return chunk;
+}
+
+void* arena_aligned_calloc(size_t count, size_t size, size_t alignment) {
+  if (alignment < ARENA_ALIGNMENT) {
+    alignment = ARENA_ALIGNMENT;
+  }
+
+  size_t total = align_size(count * size);
+  if (total == 0) {
+    total = ARENA_ALIGNMENT;
+  }
+
+  struct arena_chunk* chunk = arena_head;
+  size_t padding = 0;
+  if (chunk != NULL) {
+    uintptr_t position = (uintptr_t) (chunk->data + chunk->used);
+    padding = (alignment - position % alignment) % alignment;
+  }
+
+  if (chunk == NULL || chunk->capacity - chunk->used < total + padding) {
+    chunk = push_arena_chunk(total + alignment);
+    uintptr_t position = (uintptr_t) chunk->data;
+    padding = (alignment - position % alignment) % alignment;
+  }
+
+  void* memory = chunk->data + chunk->used + padding;
+  chunk->used += padding + total;
+  memset(memory, 0, total);
+  return memory;
+}
+
+void* arena_calloc(size_t count, size_t size) {
+  return arena_aligned_calloc(count, size, ARENA_ALIGNMENT);
+}
+
+void reset_arena(void) {
+  if (arena_head == NULL) {
+    return;
+  }
+
+  struct arena_chunk* chunk = arena_head->next;
+  while (chunk != NULL) {
+    struct arena_chunk* next = chunk->next;
+    free(chunk);
+    chunk = next;
+  }
+
+  arena_head->next = NULL;
+  arena_head->used = 0;
+}
+
+void release_arena(void) {
+  reset_arena();
+  free(arena_head);
+  arena_head = NULL;
+}
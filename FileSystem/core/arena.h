@@ -0,0 +1,46 @@
+/**
+ * @file arena.h
+ * @author yaishenka
+ * @date 19.10.2026
+ * @brief Contains per-operation arena allocator
+ *
+ * Core structs (superblock, inodes, blocks, descriptors table) are allocated
+ * from arena. Arena lives while operation lives and it is reset by
+ * destroy_super_block, so there is no need to free core structs one by one.
+ * Each thread has its own arena.
+ */
+#ifndef EXT_FILESYSTEM_CORE_ARENA_H_
+#define EXT_FILESYSTEM_CORE_ARENA_H_
+
+#include <stddef.h>
+
+/**
+ * @brief Allocate zeroed memory from arena
+ * Works like calloc, memory is aligned to max_align_t
+ * @param count
+ * @param size
+ * @return pointer to zeroed memory; exits program if there is no memory
+ */
+void* arena_calloc(size_t count, size_t size);
+
+/**
+ * @brief Allocate zeroed memory from arena with custom alignment
+ * @param count
+ * @param size
+ * @param alignment power of two
+ * @return pointer to zeroed memory aligned to alignment
+ */
+void* arena_aligned_calloc(size_t count, size_t size, size_t alignment);
+
+/**
+ * @brief Release all memory allocated from arena
+ * Largest chunk is kept to serve next operation without malloc
+ */
+void reset_arena(void);
+
+/**
+ * @brief Return all chunks of arena to system
+ */
+void release_arena(void);
+
+#endif //EXT_FILESYSTEM_CORE_ARENA_H_
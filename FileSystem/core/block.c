@@ -1,255 +1,450 @@
 /** @author yaishenka
     @date 11.03.2021 */
 #include <stdlib.h>
+#include <stddef.h>
 #include <unistd.h>
 #include <stdio.h>
 #include <errno.h>
 #include <string.h>
 #include "../utils.h"
+#include "arena.h"
 #include "block.h"
-#include "descriptors_table.h"
+#include "layout.h"
+#include "snapshot.h"
 
-size_t max_size_of_data(const struct superblock* superblock) {
-  return superblock->fs_info->block_size - sizeof(struct block_info);
+size_t sizeof_block(const struct superblock* superblock) {
+  return sizeof(struct block_info) + superblock->fs_info->block_size;
 }
 
-size_t sizeof_block_record(const struct superblock* superblock) {
-  return sizeof(uint16_t) + sizeof(char) * superblock->fs_info->max_path_len;
+char* allocate_block_record(const struct superblock* superblock) {
+  size_t alignment = superblock->fs_info->flags & FS_FLAG_ALIGNED
+                     ? IMAGE_ALIGNMENT : sizeof(uint64_t);
+  size_t header_size = (sizeof(struct block_info) + alignment - 1)
+      / alignment * alignment;
+  char* memory = (char*) arena_aligned_calloc(
+      header_size + superblock->fs_info->block_size,
+      sizeof(char),
+      alignment);
+  return memory + header_size - sizeof(struct block_info);
 }
 
-void init_block_info(struct block* block) {
-  block->block_info = (struct block_info*) calloc(1, sizeof(struct block_info));
+char* get_block_table_entry(const struct superblock* superblock,
+                            uint16_t block_id) {
+  return superblock->block_table + (size_t) block_id * sizeof(struct block_info);
 }
 
-void init_block_record(struct block_record* block_record,
-                       const struct superblock* superblock,
-                       uint16_t inode_id) {
-  block_record->inode_id = inode_id;
-  block_record->path = (char*) calloc(superblock->fs_info->max_path_len,
-                                      sizeof(char));
+ssize_t write_block_table(const int fd,
+                          const struct superblock* superblock,
+                          uint16_t first_block_id,
+                          uint16_t count) {
+  if (pwrite_while(fd,
+                   get_block_table_entry(superblock, first_block_id),
+                   (size_t) count * sizeof(struct block_info),
+                   get_block_info_offset(superblock, first_block_id)) == -1) {
+    fprintf(stderr, "%s", strerror(errno));
+    return -1;
+  }
+
+  return (ssize_t) count * sizeof(struct block_info);
 }
 
-void destruct_block_record(struct block_record* block_record) {
-  free(block_record->path);
+void init_block_views(struct block* block) {
+  block->block_info = (struct block_info*) block->record;
+  block->data = block->record + sizeof(struct block_info);
+  block->block_records = NULL;
 }
 
-ssize_t read_block_record(const int fd,
-                          struct block_record* block_record,
-                          const struct superblock* superblock) {
-  block_record->path = (char*) calloc(superblock->fs_info->max_path_len,
-                                      sizeof(char));
+void init_block_records(struct block* block,
+                        const struct superblock* superblock) {
+  block->block_records =
+      (struct block_record*) arena_calloc(get_max_records_count(superblock),
+                                          sizeof(struct block_record));
+}
 
-  uint16_t inode_id_array[1];
-  ssize_t total_read = read_while(fd, (char*) inode_id_array, sizeof(uint16_t));
+size_t get_common_prefix_length(const char* previous, const char* name) {
+  size_t length = 0;
+  while (previous[length] != '\0' && previous[length] == name[length]
+      && length < UINT8_MAX) {
+    ++length;
+  }
 
-  if (total_read == -1) {
-    fprintf(stderr, "%s", strerror(errno));
-    destruct_block_record(block_record);
-    return -1;
+  return length;
+}
+
+size_t get_block_records_size(const struct block* block) {
+  size_t size = 0;
+  const char* previous = "";
+  for (uint8_t i = 0; i < block->block_info->records_count; ++i) {
+    const char* name = block->block_records[i].path;
+    size += DIRECTORY_RECORD_HEADER_SIZE + strlen(name)
+        - get_common_prefix_length(previous, name);
+    previous = name;
   }
 
-  uint16_t inode_id = inode_id_array[0];
+  return size;
+}
 
-  block_record->inode_id = inode_id;
+bool pack_block_records(struct block* block,
+                        const struct superblock* superblock) {
+  memset(block->data, 0, get_max_data_in_block(superblock));
 
-  ssize_t readed =
-      read_while(fd, block_record->path, superblock->fs_info->max_path_len
-          * sizeof(char));
+  char* position = block->data;
+  const char* end = block->data + get_max_data_in_block(superblock);
+  const char* previous = "";
+  for (uint8_t i = 0; i < block->block_info->records_count; ++i) {
+    const char* name = block->block_records[i].path;
+    size_t prefix_length = get_common_prefix_length(previous, name);
+    size_t suffix_length = strlen(name) - prefix_length;
+    if (suffix_length > UINT8_MAX
+        || end - position
+            < (ptrdiff_t) (DIRECTORY_RECORD_HEADER_SIZE + suffix_length)) {
+      return false;
+    }
 
-  if (readed == -1) {
-    fprintf(stderr, "%s", strerror(errno));
-    destruct_block_record(block_record);
-    return -1;
+    memcpy(position, &block->block_records[i].inode_id, sizeof(uint16_t));
+    position[sizeof(uint16_t)] = (char) block->block_records[i].type;
+    position[sizeof(uint16_t) + 1] = (char) prefix_length;
+    position[sizeof(uint16_t) + 2] = (char) suffix_length;
+    memcpy(position + DIRECTORY_RECORD_HEADER_SIZE,
+           name + prefix_length,
+           suffix_length);
+    position += DIRECTORY_RECORD_HEADER_SIZE + suffix_length;
+    previous = name;
   }
 
-  return readed + total_read;
+  return true;
 }
 
-ssize_t write_block_record(const int fd,
-                           struct block_record* block_record,
-                           const struct superblock* superblock) {
-  ssize_t total_written =
-      write_while(fd, (char*) &block_record->inode_id, sizeof(uint16_t));
+bool unpack_block_records(struct block* block,
+                          const struct superblock* superblock) {
+  size_t max_path_len = superblock->fs_info->max_path_len;
+  char* names = (char*) arena_calloc(
+      (size_t) block->block_info->records_count * max_path_len, sizeof(char));
+  const char* position = block->data;
+  const char* end = block->data + get_max_data_in_block(superblock);
+  const char* previous = "";
 
-  if (total_written == -1) {
-    fprintf(stderr, "%s", strerror(errno));
-    destruct_block_record(block_record);
-    return -1;
-  }
+  for (uint8_t i = 0; i < block->block_info->records_count; ++i) {
+    if (end - position < (ptrdiff_t) DIRECTORY_RECORD_HEADER_SIZE) {
+      return false;
+    }
 
-  ssize_t written = write_while(fd,
-                                (char*) block_record->path,
-                                superblock->fs_info->max_path_len
-                                    * sizeof(char));
+    uint8_t type = (uint8_t) position[sizeof(uint16_t)];
+    uint8_t prefix_length = (uint8_t) position[sizeof(uint16_t) + 1];
+    uint8_t suffix_length = (uint8_t) position[sizeof(uint16_t) + 2];
+    if (prefix_length > strlen(previous)
+        || (size_t) prefix_length + suffix_length >= max_path_len
+        || end - position
+            < (ptrdiff_t) (DIRECTORY_RECORD_HEADER_SIZE + suffix_length)) {
+      return false;
+    }
 
-  if (written == -1) {
-    fprintf(stderr, "%s", strerror(errno));
-    destruct_block_record(block_record);
-    return -1;
+    char* name = names + i * max_path_len;
+    memcpy(&block->block_records[i].inode_id, position, sizeof(uint16_t));
+    block->block_records[i].type = type;
+    memcpy(name, previous, prefix_length);
+    memcpy(name + prefix_length,
+           position + DIRECTORY_RECORD_HEADER_SIZE,
+           suffix_length);
+    block->block_records[i].path = name;
+    position += DIRECTORY_RECORD_HEADER_SIZE + suffix_length;
+    previous = name;
   }
 
-  return written + total_written;
+  return true;
 }
 
 void init_block(struct block* block,
                 const struct superblock* superblock,
                 const uint16_t block_id,
                 const uint16_t inode_id) {
-  init_block_info(block);
+  block->record = allocate_block_record(superblock);
+  init_block_views(block);
   block->block_info->block_id = block_id;
   block->block_info->inode_id = inode_id;
   block->block_info->data_size = 0;
   block->block_info->records_count = 0;
-  block->data = (char*) calloc(max_size_of_data(superblock), sizeof(char));
-  block->block_records = NULL;
 }
 
 void init_block_with_records(struct block* block,
                              const struct superblock* superblock,
                              const uint16_t block_id,
-                             const uint16_t inode_id,
-                             const uint8_t records_count) {
+                             const uint16_t inode_id) {
   init_block(block, superblock, block_id, inode_id);
-  block->block_info->records_count = records_count;
-  block->block_records = (struct block_record*) calloc(records_count,
-                                                       sizeof(struct block_record));
+  init_block_records(block, superblock);
+}
+
+bool can_add_block_record(const struct block* block,
+                          const struct superblock* superblock,
+                          const char* path) {
+  return block->block_info->records_count < get_max_records_count(superblock)
+      && get_block_records_size(block) + DIRECTORY_RECORD_HEADER_SIZE
+          + strlen(path) <= get_max_data_in_block(superblock);
 }
 
-void destruct_block(struct block* block) {
-  if (block->data != NULL) {
-    free(block->data);
+bool add_block_record(struct block* block,
+                      const struct superblock* superblock,
+                      const uint16_t inode_id,
+                      const uint8_t type,
+                      const char* path) {
+  size_t path_length = strlen(path);
+  if (path_length >= superblock->fs_info->max_path_len
+      || path_length > UINT8_MAX) {
+    fprintf(stderr, "Name is too long!\n");
+    return false;
   }
 
-  for (uint8_t i = 0; i < block->block_info->records_count; ++i) {
-    destruct_block_record(block->block_records + i);
+  if (!can_add_block_record(block, superblock, path)) {
+    return false;
   }
-  if (block->block_records != NULL) {
-    free(block->block_records);
+
+  if (block->block_records == NULL) {
+    init_block_records(block, superblock);
   }
 
-  free(block->block_info);
+  uint8_t record_id = block->block_info->records_count;
+  block->block_records[record_id].inode_id = inode_id;
+  block->block_records[record_id].type = type;
+  block->block_records[record_id].path =
+      (char*) arena_calloc(superblock->fs_info->max_path_len, sizeof(char));
+  memcpy(block->block_records[record_id].path, path, path_length);
+  block->block_info->records_count += 1;
+
+  return true;
+}
+
+void remove_block_record(struct block* block, const uint8_t record_id) {
+  uint8_t last_record_id = block->block_info->records_count - 1;
+  memmove(block->block_records + record_id,
+          block->block_records + record_id + 1,
+          (size_t) (last_record_id - record_id) * sizeof(struct block_record));
+  block->block_info->records_count -= 1;
 }
 
 ssize_t read_block(const int fd,
                    struct block* block,
                    uint16_t block_id,
                    const struct superblock* superblock) {
-  init_block_info(block);
-  block->data = (char*) calloc(max_size_of_data(superblock), sizeof(char));
-  block->block_records = NULL;
-  lseek(fd,
-        sizeof_superblock(superblock) + sizeof_descriptors_table(superblock)
-            + sizeof_inodes_block(superblock)
-            + block_id * superblock->fs_info->block_size,
-        SEEK_SET);
+  const char* entry = get_block_table_entry(superblock, block_id);
+  if (superblock->backing != NULL
+      && is_zero_memory(entry, sizeof(struct block_info))) {
+    return read_block(superblock->backing_fd,
+                      block,
+                      block_id,
+                      superblock->backing);
+  }
+
+  block->record = allocate_block_record(superblock);
+  init_block_views(block);
+  memcpy(block->record, entry, sizeof(struct block_info));
 
-  ssize_t total_read =
-      read_while(fd, (char*) block->block_info, sizeof(struct block_info));
+  ssize_t total_read = pread_while(fd,
+                                   block->data,
+                                   superblock->fs_info->block_size,
+                                   get_block_offset(superblock, block_id));
 
   if (total_read == -1) {
     fprintf(stderr, "%s", strerror(errno));
-    free(block->block_info);
-    free(block->data);
+    return -1;
+  }
+
+  if (!is_record_checksum_valid(block->record, sizeof_block(superblock))) {
+    fprintf(stderr, "Block checksum mismatch!\n");
     return -1;
   }
 
   if (block->block_info->records_count != 0
       && block->block_info->data_size != 0) {
     fprintf(stderr, "Block with data and records!");
-    destruct_block(block);
+    return -1;
+  }
+
+  if (block->block_info->records_count > get_max_records_count(superblock)) {
+    fprintf(stderr, "Block with too many records!");
     return -1;
   }
 
   if (block->block_info->records_count != 0) {
-    block->block_records =
-        (struct block_record*) calloc(block->block_info->records_count,
-                                      sizeof(struct block_record));
-
-    for (uint8_t i = 0; i < block->block_info->records_count; ++i) {
-      ssize_t
-          readed = read_block_record(fd, block->block_records + i, superblock);
-      if (readed == -1) {
-        fprintf(stderr, "%s", strerror(errno));
-        destruct_block(block);
+    init_block_records(block, superblock);
+
+    if (!unpack_block_records(block, superblock)) {
+      fprintf(stderr, "Directory block is corrupted!\n");
+      return -1;
+    }
+  }
+
+  return total_read;
+}
+
+ssize_t read_blocks_run(const int fd,
+                        const struct superblock* superblock,
+                        uint16_t first_block_id,
+                        uint16_t count,
+                        char* records) {
+  size_t block_size = superblock->fs_info->block_size;
+  char* data = (char*) arena_calloc((size_t) count * block_size, sizeof(char));
+  ssize_t total_read = pread_while(fd,
+                                   data,
+                                   (size_t) count * block_size,
+                                   get_block_offset(superblock, first_block_id));
+  if (total_read == -1) {
+    fprintf(stderr, "%s", strerror(errno));
+    return -1;
+  }
+
+  for (uint16_t i = 0; i < count; ++i) {
+    char* record = records + i * sizeof_block(superblock);
+    const char* entry = get_block_table_entry(superblock, first_block_id + i);
+    if (superblock->backing != NULL
+        && is_zero_memory(entry, sizeof(struct block_info))) {
+      if (read_blocks_run(superblock->backing_fd,
+                          superblock->backing,
+                          first_block_id + i,
+                          1,
+                          record) == -1) {
         return -1;
       }
-
-      total_read += readed;
+      continue;
     }
 
-    return total_read;
-  } else if (block->block_info->data_size != 0) {
-    ssize_t readed = read_while(fd, block->data, block->block_info->data_size);
-    total_read += readed;
+    memcpy(record, entry, sizeof(struct block_info));
+    memcpy(record + sizeof(struct block_info), data + i * block_size, block_size);
   }
 
   return total_read;
 }
 
-ssize_t write_block(const int fd,
-                    struct block* block,
-                    const struct superblock* superblock) {
-  lseek(fd,
-        sizeof_superblock(superblock) + sizeof_descriptors_table(superblock)
-            + sizeof_inodes_block(superblock)
-            + block->block_info->block_id * superblock->fs_info->block_size,
-        SEEK_SET);
+ssize_t write_blocks_run(const int fd,
+                         const struct superblock* superblock,
+                         uint16_t first_block_id,
+                         uint16_t count,
+                         char* records) {
+  if (superblock->snapshot_inodes != NULL) {
+    fprintf(stderr, "Snapshot is read-only!\n");
+    return -1;
+  }
 
-  ssize_t total_written =
-      write_while(fd, (char*) block->block_info, sizeof(struct block_info));
+  size_t block_size = superblock->fs_info->block_size;
+  char* data = (char*) arena_calloc((size_t) count * block_size, sizeof(char));
+  for (uint16_t i = 0; i < count; ++i) {
+    char* record = records + i * sizeof_block(superblock);
+    set_record_checksum(record, sizeof_block(superblock));
+    memcpy(get_block_table_entry(superblock, first_block_id + i),
+           record,
+           sizeof(struct block_info));
+    memcpy(data + i * block_size, record + sizeof(struct block_info), block_size);
+  }
 
+  ssize_t total_written = pwrite_while(fd,
+                                       data,
+                                       (size_t) count * block_size,
+                                       get_block_offset(superblock,
+                                                        first_block_id));
   if (total_written == -1) {
     fprintf(stderr, "%s", strerror(errno));
     return -1;
   }
 
+  if (write_block_table(fd, superblock, first_block_id, count) == -1) {
+    return -1;
+  }
+
+  return total_written;
+}
+
+ssize_t write_block(const int fd,
+                    struct block* block,
+                    const struct superblock* superblock) {
   if (block->block_info->records_count != 0
       && block->block_info->data_size != 0) {
     fprintf(stderr, "Block with data and records!");
     return -1;
   }
 
-  if (block->block_records != 0) {
-    for (uint8_t i = 0; i < block->block_info->records_count; ++i) {
-      ssize_t written =
-          write_block_record(fd, block->block_records + i, superblock);
+  if (block->block_info->records_count != 0
+      && !pack_block_records(block, superblock)) {
+    fprintf(stderr, "Directory records don't fit in block!\n");
+    return -1;
+  }
 
-      if (written == -1) {
-        fprintf(stderr, "%s", strerror(errno));
-        destruct_block(block);
-        return -1;
-      }
+  if (superblock->snapshot_inodes != NULL) {
+    fprintf(stderr, "Snapshot is read-only!\n");
+    return -1;
+  }
 
-      total_written += written;
-    }
-  } else if (block->block_info->data_size != 0 && block->data != NULL) {
-    ssize_t written = write_while(fd,
-                                  block->data,
-                                  max_size_of_data(superblock) * sizeof(char));
+  uint16_t block_id = block->block_info->block_id;
+  set_record_checksum(block->record, sizeof_block(superblock));
+  ssize_t total_written =
+      pwrite_while(fd,
+                   block->data,
+                   superblock->fs_info->block_size,
+                   get_block_offset(superblock, block_id));
 
-    if (written == -1) {
-      fprintf(stderr, "%s", strerror(errno));
-      return -1;
-    }
+  if (total_written == -1) {
+    fprintf(stderr, "%s", strerror(errno));
+    return -1;
+  }
 
-    total_written += written;
+  memcpy(get_block_table_entry(superblock, block_id),
+         block->record,
+         sizeof(struct block_info));
+  if (write_block_table(fd, superblock, block_id, 1) == -1) {
+    return -1;
   }
 
   return total_written;
 }
 
+uint16_t find_tail_block(const struct superblock* superblock, uint32_t size) {
+  uint16_t blocks_count = superblock->fs_info->blocks_count;
+  for (uint16_t block_id = 0; block_id < blocks_count; ++block_id) {
+    struct block_info block_info;
+    memcpy(&block_info,
+           get_block_table_entry(superblock, block_id),
+           sizeof(struct block_info));
+    if (superblock->reserved_blocks_mask[block_id]
+        && !superblock->unwritten_blocks_mask[block_id]
+        && block_info.inode_id == superblock->fs_info->inodes_count
+        && block_info.records_count == 0
+        && !is_snapshot_block(superblock, block_id)
+        && superblock->block_references[block_id] < UINT8_MAX
+        && get_max_data_in_block(superblock) - block_info.data_size >= size) {
+      return block_id;
+    }
+  }
+
+  return blocks_count;
+}
+
+uint16_t get_block_owner(const struct superblock* superblock,
+                         uint16_t block_id) {
+  struct block_info block_info;
+  memcpy(&block_info,
+         get_block_table_entry(superblock, block_id),
+         sizeof(struct block_info));
+  return block_info.inode_id;
+}
+
 uint8_t get_max_records_count(const struct superblock* superblock) {
-  return (uint8_t) (superblock->fs_info->block_size - sizeof(struct block_info))
-      / sizeof_block_record(superblock);
+  if (superblock->layout.is_default) {
+    return DEFAULT_MAX_RECORDS_COUNT;
+  }
+
+  return superblock->layout.max_records_count;
 }
 
 uint32_t get_max_data_in_block(const struct superblock* superblock) {
-  return superblock->fs_info->block_size - sizeof(struct block_info);
+  if (superblock->layout.is_default) {
+    return DEFAULT_MAX_DATA_IN_BLOCK;
+  }
+
+  return superblock->layout.max_data_in_block;
 }
 
 uint32_t get_max_data_size_of_all_blocks(const struct superblock* superblock) {
   return (uint32_t) (get_max_data_in_block(superblock))
-      * superblock->fs_info->blocks_count_in_inode;
+      * superblock->fs_info->blocks_count_in_inode
+      * get_cluster_size(superblock);
 }
 
 uint32_t get_remain_data(const struct block* block,
@@ -14,16 +14,35 @@
 
 /**
  * @brief Contains information about filename/dirname
+ * path is zero-terminated name decoded from directory block.
+ * type is RECORD_TYPE_FILE or RECORD_TYPE_DIR (like d_type of readdir),
+ * so directory is listed without reading inodes of its entries.
+ * On disk records are packed one after another: inode_id, type, length of
+ * prefix shared with name of previous record, length of the rest of name and
+ * the rest of name itself (without zero). "." and ".." aren't stored,
+ * they are synthesized from inode (see inode_info->parent_id)
  */
 struct __attribute__((__packed__)) block_record {
   uint16_t inode_id;
+  uint8_t type;
   char* path;
 };
 
+#define RECORD_TYPE_FILE 1
+#define RECORD_TYPE_DIR 2
+
+/**
+ * @brief Size of on-disk directory record without name
+ */
+#define DIRECTORY_RECORD_HEADER_SIZE (sizeof(uint16_t) + 3 * sizeof(uint8_t))
+
 /**
  * @brief Contains meta info about block
+ * It is stored in block table, not in block (see core/layout.h).
+ * checksum is CRC32C of the rest of block_info and data of block
  */
 struct __attribute__((__packed__)) block_info {
+  uint32_t checksum;
   uint16_t block_id;
   uint16_t inode_id;
   uint8_t records_count;
@@ -33,30 +52,26 @@ struct __attribute__((__packed__)) block_info {
 /**
  * @brief Contains information about block
  *
- * Block can contain file data or records about directory
+ * Block can contain file data or records about directory.
+ * Tail block contains last blocks of several files (see INODE_FLAG_TAIL),
+ * its inode_id is inodes_count and data_size is count of packed bytes.
+ * Snapshot blocks have the same inode_id, see is_snapshot_block().
+ * record is block_info followed by block_size bytes of data, it is allocated
+ * from arena so data is aligned. block_info and data are views into it.
+ * block_records are decoded from data for directory blocks
  */
-struct __attribute__((__packed__)) block {
+struct block {
   struct block_info* block_info;
   struct block_record* block_records;
   char* data;
+  char* record;
 };
 
 /**
- * @brief Constructor of block record
- * Init block record and set its path array to char[max_len_path]
- * @param block_record
  * @param superblock
- * @param inode_id id of inode with associated with dir or file
- */
-void init_block_record(struct block_record* block_record,
-                       const struct superblock* superblock,
-                       uint16_t inode_id);
-
-/**
- * @brief Destructor of block_record
- * @param block_record
+ * @return size of block record: block_info and data
  */
-void destruct_block_record(struct block_record* block_record);
+size_t sizeof_block(const struct superblock* superblock);
 
 /**
  * @brief Constructor of block
@@ -73,40 +88,111 @@ void init_block(struct block* block,
 
 /**
  * @brief Constructor of block
- * Init block and set its block_records array to bloc_record[records_count]
+ * Init block without records and set its block_records array to
+ * block_record[get_max_records_count()], so records can be added
  * @param block
  * @param superblock
  * @param block_id
  * @param inode_id
- * @param records_count
  */
 void init_block_with_records(struct block* block,
                              const struct superblock* superblock,
                              uint16_t block_id,
-                             uint16_t inode_id,
-                             uint8_t records_count);
+                             uint16_t inode_id);
 
 /**
- * @brief Destructor of block
+ * @brief Check if record fits in directory block
  * @param block
+ * @param superblock
+ * @param path name of file or dir
+ * @return true if record with path can be added
  */
-void destruct_block(struct block* block);
+bool can_add_block_record(const struct block* block,
+                          const struct superblock* superblock,
+                          const char* path);
+
+/**
+ * @brief Add record to directory block
+ * Records are packed when block is written. Records array of empty
+ * directory block is allocated on first record
+ * @param block
+ * @param superblock
+ * @param inode_id
+ * @param type RECORD_TYPE_FILE or RECORD_TYPE_DIR
+ * @param path name of file or dir
+ * @return true if all ok; false if block is full or path is too long
+ */
+bool add_block_record(struct block* block,
+                      const struct superblock* superblock,
+                      uint16_t inode_id,
+                      uint8_t type,
+                      const char* path);
+
+/**
+ * @brief Remove record from block
+ * Next records are moved down, so order of records is kept: names are
+ * prefix compressed against previous record, and keeping order guarantees
+ * that packed records only shrink after removal
+ * @param block
+ * @param record_id
+ */
+void remove_block_record(struct block* block, uint8_t record_id);
 
 /**
  * @brief Read block from memory
+ * block_info is taken from block table, data is read with one pread.
+ * Block which was never written to overlay is read from backing image
  * @param fd
  * @param block
  * @param block_id
  * @param superblock
- * @return sizeof(block) if reading is ok; -1 otherwise and destruct block object
+ * @return sizeof(block) if reading is ok; -1 otherwise
+ * @note Records array of directory block has capacity get_max_records_count()
  */
 ssize_t read_block(int fd,
                    struct block* block,
                    uint16_t block_id,
                    const struct superblock* superblock);
 
+/**
+ * @brief Read records of run of blocks
+ * Data of run is read with one pread. Records which were never written
+ * to overlay are read from backing image. Checksums aren't checked
+ * @param fd
+ * @param superblock
+ * @param first_block_id
+ * @param count
+ * @param records buffer of count * sizeof_block() bytes
+ * @return size of data of run if reading is ok; -1 otherwise
+ */
+ssize_t read_blocks_run(int fd,
+                        const struct superblock* superblock,
+                        uint16_t first_block_id,
+                        uint16_t count,
+                        char* records);
+
+/**
+ * @brief Write records of run of blocks
+ * Checksums of records are set. Data of run and its block_info entries
+ * are written with one pwrite each
+ * @param fd
+ * @param superblock
+ * @param first_block_id
+ * @param count
+ * @param records count * sizeof_block() bytes
+ * @return size of data of run if writing is ok; -1 otherwise
+ */
+ssize_t write_blocks_run(int fd,
+                         const struct superblock* superblock,
+                         uint16_t first_block_id,
+                         uint16_t count,
+                         char* records);
+
 /**
  * @brief Write
+ * Records of directory block are packed to its data, nothing is written
+ * if they don't fit in it.
+ * Data is written to block, block_info to block table
  * @param fd
  * @param block
  * @param superblock
@@ -116,6 +202,23 @@ ssize_t write_block(int fd,
                     struct block* block,
                     const struct superblock* superblock);
 
+/**
+ * @brief Find tail block with free space
+ * Only block table is looked through, nothing is read
+ * @param superblock
+ * @param size size of tail
+ * @return id of tail block if found; superblock->fs_info->blocks_count otherwise
+ */
+uint16_t find_tail_block(const struct superblock* superblock, uint32_t size);
+
+/**
+ * @brief Get inode_id of block from block table, nothing is read
+ * @param superblock
+ * @param block_id
+ * @return inode_id of block; inodes_count for tail and snapshot blocks
+ */
+uint16_t get_block_owner(const struct superblock* superblock, uint16_t block_id);
+
 /**
  * @param superblock
  * @return Maximum number of records in a block
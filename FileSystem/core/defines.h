@@ -13,8 +13,13 @@
 #define BLOCKS_COUNT_IN_INODE 8
 #define MAX_PATH_LEN 16
 #define DESCRIPTORS_COUNT 16
+#define SNAPSHOTS_COUNT 8
+#define BACKING_PATH_LEN 256
 #define MAGIC 0xFAF
 #define ROOT_INODE_ID 0
 #define ROOT_BLOCK_ID 0
+#define IMAGE_ALIGNMENT 4096
+#define ALIGNED_BLOCK_SIZE 4096
+#define CLUSTER_SIZE 8
 
 #endif //EXT_FILESYSTEM_CORE_DEFINES_H_
@@ -0,0 +1,192 @@
+/** @author yaishenka
+    @date 19.10.2026 */
+
+#include <stdio.h>
+#include "defrag.h"
+#include "block.h"
+#include "file.h"
+#include "methods.h"
+#include "arena.h"
+
+uint16_t count_fragments(const struct inode* inode,
+                         const struct superblock* superblock) {
+  if (is_inline_inode(inode)) {
+    return 0;
+  }
+
+  uint16_t cluster_size = get_inode_cluster_size(inode, superblock);
+  uint16_t fragments = 0;
+  bool is_previous_stored = false;
+  for (uint16_t index = 0; index < inode->inode_info->blocks_count; ++index) {
+    bool is_stored =
+        inode->block_ids[index] != superblock->fs_info->blocks_count;
+    if (is_stored && (!is_previous_stored
+        || inode->block_ids[index]
+            != inode->block_ids[index - 1] + cluster_size)) {
+      ++fragments;
+    }
+    is_previous_stored = is_stored;
+  }
+
+  return fragments;
+}
+
+bool move_block(const int fd,
+                const struct superblock* superblock,
+                struct inode* inode,
+                uint16_t block_index,
+                uint16_t new_block_id) {
+  uint16_t old_block_id = inode->block_ids[block_index];
+
+  if (!superblock->unwritten_blocks_mask[old_block_id]) {
+    struct block block;
+    if (read_block(fd, &block, old_block_id, superblock) == -1) {
+      fprintf(stderr, "Can't read block. Abort!\n");
+      return false;
+    }
+
+    block.block_info->block_id = new_block_id;
+    if (write_block(fd, &block, superblock) == -1) {
+      fprintf(stderr, "Can't write block. Abort!\n");
+      return false;
+    }
+  }
+
+  superblock->reserved_blocks_mask[new_block_id] = true;
+  superblock->unwritten_blocks_mask[new_block_id] =
+      superblock->unwritten_blocks_mask[old_block_id];
+  if (superblock->block_fingerprints != NULL) {
+    set_block_fingerprint(superblock,
+                          new_block_id,
+                          get_block_fingerprint(superblock, old_block_id));
+  }
+  free_block(superblock, old_block_id);
+  inode->block_ids[block_index] = new_block_id;
+  return true;
+}
+
+bool is_movable_block(const struct inode* inode,
+                      const struct superblock* superblock,
+                      uint16_t block_index) {
+  return !is_hole_block(inode, superblock, block_index)
+      && !is_shared_block(superblock, inode->block_ids[block_index]);
+}
+
+ssize_t defrag_inode(const int fd,
+                     const struct superblock* superblock,
+                     struct inode* inode) {
+  uint16_t fragments = count_fragments(inode, superblock);
+  if (fragments <= 1 || is_clustered_inode(inode)) {
+    return fragments;
+  }
+
+  uint16_t stored_count = 0;
+  for (uint16_t index = 0; index < inode->inode_info->blocks_count; ++index) {
+    if (is_hole_block(inode, superblock, index)) {
+      continue;
+    }
+
+    if (!is_movable_block(inode, superblock, index)) {
+      return fragments;
+    }
+    ++stored_count;
+  }
+
+  uint16_t run_start = find_free_blocks_run(superblock, 0, stored_count);
+  if (run_start == superblock->fs_info->blocks_count) {
+    return fragments;
+  }
+
+  for (uint16_t index = 0; index < inode->inode_info->blocks_count; ++index) {
+    if (!is_movable_block(inode, superblock, index)) {
+      continue;
+    }
+
+    if (!move_block(fd, superblock, inode, index, run_start++)) {
+      return -1;
+    }
+  }
+
+  if (write_inode(fd, inode, superblock) == -1) {
+    fprintf(stderr, "Can't write inode. Abort!\n");
+    return -1;
+  }
+
+  return count_fragments(inode, superblock);
+}
+
+ssize_t compact_blocks(const int fd, const struct superblock* superblock) {
+  reclaim_orphans(fd, superblock);
+
+  uint16_t inodes_count = superblock->fs_info->inodes_count;
+  uint16_t blocks_count = superblock->fs_info->blocks_count;
+  struct inode* inodes =
+      (struct inode*) arena_calloc(inodes_count, sizeof(struct inode));
+  bool* is_inode_changed = (bool*) arena_calloc(inodes_count, sizeof(bool));
+  uint16_t* owner_inode =
+      (uint16_t*) arena_calloc(blocks_count, sizeof(uint16_t));
+  uint16_t* owner_index =
+      (uint16_t*) arena_calloc(blocks_count, sizeof(uint16_t));
+
+  for (uint16_t block_id = 0; block_id < blocks_count; ++block_id) {
+    owner_inode[block_id] = inodes_count;
+  }
+
+  for (uint16_t inode_id = 0; inode_id < inodes_count; ++inode_id) {
+    if (!superblock->reserved_inodes_mask[inode_id]) {
+      continue;
+    }
+
+    struct inode* inode = &inodes[inode_id];
+    if (read_inode(fd, inode, inode_id, superblock) == -1) {
+      fprintf(stderr, "Can't read inode. Abort!\n");
+      return -1;
+    }
+
+    if (is_inline_inode(inode) || is_clustered_inode(inode)) {
+      continue;
+    }
+
+    for (uint16_t index = 0; index < inode->inode_info->blocks_count;
+         ++index) {
+      if (!is_hole_block(inode, superblock, index)) {
+        owner_inode[inode->block_ids[index]] = inode_id;
+        owner_index[inode->block_ids[index]] = index;
+      }
+    }
+  }
+
+  uint16_t destination = 0;
+  for (uint16_t block_id = 0; block_id < blocks_count; ++block_id) {
+    if (!superblock->reserved_blocks_mask[block_id]) {
+      continue;
+    }
+
+    uint16_t inode_id = owner_inode[block_id];
+    if (inode_id == inodes_count || destination == block_id
+        || is_shared_block(superblock, block_id)) {
+      destination = block_id + 1;
+      continue;
+    }
+
+    if (!move_block(fd,
+                    superblock,
+                    &inodes[inode_id],
+                    owner_index[block_id],
+                    destination)) {
+      return -1;
+    }
+    is_inode_changed[inode_id] = true;
+    ++destination;
+  }
+
+  for (uint16_t inode_id = 0; inode_id < inodes_count; ++inode_id) {
+    if (is_inode_changed[inode_id]
+        && write_inode(fd, &inodes[inode_id], superblock) == -1) {
+      fprintf(stderr, "Can't write inode. Abort!\n");
+      return -1;
+    }
+  }
+
+  return destination;
+}
@@ -0,0 +1,68 @@
+/**
+ * @file defrag.h
+ * @author yaishenka
+ * @date 19.10.2026
+ * @brief Contains methods to defragment and compact blocks of FS
+ */
+#ifndef EXT_FILESYSTEM_CORE_DEFRAG_H_
+#define EXT_FILESYSTEM_CORE_DEFRAG_H_
+#include <stdint.h>
+#include <stdbool.h>
+#include <unistd.h>
+#include "superblock.h"
+#include "inode.h"
+
+/**
+ * @brief Count fragments of file
+ * Fragment is run of stored blocks (or clusters) with consecutive ids
+ * @param inode
+ * @param superblock
+ * @return count of fragments
+ */
+uint16_t count_fragments(const struct inode* inode,
+                         const struct superblock* superblock);
+
+/**
+ * @brief Move block of inode to another place
+ * Inode isn't written. Superblock should be written by caller
+ * @param fd opened fd
+ * @param superblock
+ * @param inode
+ * @param block_index index of block in inode
+ * @param new_block_id free block
+ * @return true if all ok; false otherwise
+ */
+bool move_block(int fd,
+                const struct superblock* superblock,
+                struct inode* inode,
+                uint16_t block_index,
+                uint16_t new_block_id);
+
+/**
+ * @brief Move blocks of file to one contiguous run
+ * Files with shared blocks (see FS_FLAG_DEDUP) stay in place: moving
+ * only their own blocks would split them into more fragments. Clusters
+ * stay in place too.
+ * Superblock should be written by caller
+ * @param fd opened fd
+ * @param superblock
+ * @param inode
+ * @return count of fragments after defragmentation if all ok; -1 otherwise
+ */
+ssize_t defrag_inode(int fd,
+                     const struct superblock* superblock,
+                     struct inode* inode);
+
+/**
+ * @brief Pack used blocks to the beginning of blocks region
+ * Orphans are reclaimed first. Order of blocks is kept,
+ * so contiguous files stay contiguous. Shared blocks and clusters
+ * stay in place.
+ * Superblock should be written by caller
+ * @param fd opened fd
+ * @param superblock
+ * @return count of blocks which are needed after compaction if all ok; -1 otherwise
+ */
+ssize_t compact_blocks(int fd, const struct superblock* superblock);
+
+#endif //EXT_FILESYSTEM_CORE_DEFRAG_H_
@@ -6,58 +6,54 @@
 #include <errno.h>
 #include <string.h>
 #include "../utils.h"
+#include "arena.h"
+#include "layout.h"
 #include "descriptors_table.h"
 
 void init_descriptors_table(struct descriptors_table* descriptors_table,
                             const struct superblock* superblock) {
   descriptors_table->reserved_fd =
-      (bool*) calloc(superblock->fs_info->descriptors_count, sizeof(bool));
+      (bool*) arena_calloc(superblock->fs_info->descriptors_count,
+                           sizeof(bool));
   descriptors_table->fd_to_inode =
-      (uint16_t*) calloc(superblock->fs_info->descriptors_count,
-                         sizeof(uint16_t));
+      (uint16_t*) arena_calloc(superblock->fs_info->descriptors_count,
+                               sizeof(uint16_t));
   descriptors_table->fd_to_position =
-      (uint32_t*) calloc(superblock->fs_info->descriptors_count,
-                         sizeof(uint32_t));
-}
-
-void destruct_descriptors_table(struct descriptors_table* descriptors_table,
-                                const struct superblock* superblock) {
-  free(descriptors_table->reserved_fd);
-  free(descriptors_table->fd_to_inode);
-  free(descriptors_table->fd_to_position);
+      (uint64_t*) arena_calloc(superblock->fs_info->descriptors_count,
+                               sizeof(uint64_t));
 }
 
 ssize_t read_descriptors_table(const int fd,
                                struct descriptors_table* descriptors_table,
                                const struct superblock* superblock) {
   init_descriptors_table(descriptors_table, superblock);
-  lseek(fd, sizeof_superblock(superblock), SEEK_SET);
+  size_t offset = get_descriptors_table_offset(superblock);
   uint16_t descriptors_count = superblock->fs_info->descriptors_count;
-  ssize_t total_readed = read_while(fd,
-                                    (char*) descriptors_table->reserved_fd,
-                                    sizeof(bool) * descriptors_count);
+  ssize_t total_readed = pread_while(fd,
+                                     (char*) descriptors_table->reserved_fd,
+                                     sizeof(bool) * descriptors_count,
+                                     offset);
   if (total_readed == -1) {
     fprintf(stderr, "%s", strerror(errno));
-    destruct_descriptors_table(descriptors_table, superblock);
     return -1;
   }
 
-  ssize_t readed = read_while(fd,
-                              (char*) descriptors_table->fd_to_inode,
-                              sizeof(uint16_t) * descriptors_count);
+  ssize_t readed = pread_while(fd,
+                               (char*) descriptors_table->fd_to_inode,
+                               sizeof(uint16_t) * descriptors_count,
+                               offset + total_readed);
   if (readed == -1) {
     fprintf(stderr, "%s", strerror(errno));
-    destruct_descriptors_table(descriptors_table, superblock);
     return -1;
   }
   total_readed += readed;
 
-  readed = read_while(fd,
-                      (char*) descriptors_table->fd_to_position,
-                      sizeof(uint32_t) * descriptors_count);
+  readed = pread_while(fd,
+                       (char*) descriptors_table->fd_to_position,
+                       sizeof(uint64_t) * descriptors_count,
+                       offset + total_readed);
   if (readed == -1) {
     fprintf(stderr, "%s", strerror(errno));
-    destruct_descriptors_table(descriptors_table, superblock);
     return -1;
   }
   total_readed += readed;
@@ -68,29 +64,32 @@ ssize_t read_descriptors_table(const int fd,
 ssize_t write_descriptor_table(const int fd,
                                struct descriptors_table* descriptors_table,
                                const struct superblock* superblock) {
-  lseek(fd, sizeof_superblock(superblock), SEEK_SET);
+  size_t offset = get_descriptors_table_offset(superblock);
   uint16_t descriptors_count = superblock->fs_info->descriptors_count;
 
-  ssize_t total_written = write_while(fd,
-                                      (char*) descriptors_table->reserved_fd,
-                                      sizeof(bool) * descriptors_count);
+  ssize_t total_written = pwrite_while(fd,
+                                       (char*) descriptors_table->reserved_fd,
+                                       sizeof(bool) * descriptors_count,
+                                       offset);
   if (total_written == -1) {
     fprintf(stderr, "%s", strerror(errno));
     return -1;
   }
 
-  ssize_t written = write_while(fd,
-                                (char*) descriptors_table->fd_to_inode,
-                                sizeof(uint16_t) * descriptors_count);
+  ssize_t written = pwrite_while(fd,
+                                 (char*) descriptors_table->fd_to_inode,
+                                 sizeof(uint16_t) * descriptors_count,
+                                 offset + total_written);
   if (written == -1) {
     fprintf(stderr, "%s", strerror(errno));
     return -1;
   }
   total_written += written;
 
-  written = write_while(fd,
-                        (char*) descriptors_table->fd_to_position,
-                        sizeof(uint32_t) * descriptors_count);
+  written = pwrite_while(fd,
+                         (char*) descriptors_table->fd_to_position,
+                         sizeof(uint64_t) * descriptors_count,
+                         offset + total_written);
   if (written == -1) {
     fprintf(stderr, "%s", strerror(errno));
     return -1;
@@ -103,11 +102,9 @@ ssize_t write_descriptor_table(const int fd,
 int reserve_descriptor(struct descriptors_table* descriptors_table,
                        uint16_t inode_id,
                        const struct superblock* superblock) {
-  for (uint16_t fd = 0; fd < superblock->fs_info->descriptors_count; ++fd) {
-    if (descriptors_table->fd_to_inode[fd] == inode_id) {
-      fprintf(stderr, "Can't open same inode twice. Abort!\n");
-      return -1;
-    }
+  if (is_inode_opened(descriptors_table, inode_id, superblock)) {
+    fprintf(stderr, "Can't open same inode twice. Abort!\n");
+    return -1;
   }
 
   for (uint16_t fd = 0; fd < superblock->fs_info->descriptors_count; ++fd) {
@@ -138,8 +135,21 @@ int free_descriptor(struct descriptors_table* descriptors_table,
   return fd;
 }
 
-uint16_t sizeof_descriptors_table(const struct superblock* superblock) {
+bool is_inode_opened(const struct descriptors_table* descriptors_table,
+                     uint16_t inode_id,
+                     const struct superblock* superblock) {
+  for (uint16_t fd = 0; fd < superblock->fs_info->descriptors_count; ++fd) {
+    if (descriptors_table->reserved_fd[fd]
+        && descriptors_table->fd_to_inode[fd] == inode_id) {
+      return true;
+    }
+  }
+
+  return false;
+}
+
+size_t sizeof_descriptors_table(const struct superblock* superblock) {
   uint16_t descriptors_count = superblock->fs_info->descriptors_count;
   return descriptors_count
-      * (sizeof(bool) + sizeof(uint16_t) + sizeof(uint32_t));
+      * (sizeof(bool) + sizeof(uint16_t) + sizeof(uint64_t));
 }
@@ -18,32 +18,25 @@
 struct __attribute__((__packed__)) descriptors_table {
   bool* reserved_fd;
   uint16_t* fd_to_inode;
-  uint32_t* fd_to_position;
+  uint64_t* fd_to_position;
 };
 
 /**
  * @brief Constructor of descriptors_table
- * Init descriptors table with metadata from superblock
+ * Init descriptors table with metadata from superblock.
+ * Table is allocated from arena and released with it
  * @param descriptors_table
  * @param superblock
  */
 void init_descriptors_table(struct descriptors_table* descriptors_table,
                             const struct superblock* superblock);
 
-/**
- * @brief Destructor of superblock
- * @param descriptors_table
- * @param superblock
- */
-void destruct_descriptors_table(struct descriptors_table* descriptors_table,
-                                const struct superblock* superblock);
-
 /**
  * @brief Read descriptors_table from memory
  * @param fd opened fd
  * @param descriptors_table
  * @param superblock
- * @return sizeof(descriptor_table) of reading is ok; -1 otherwise and destruct descriptors_table
+ * @return sizeof(descriptor_table) of reading is ok; -1 otherwise
  */
 ssize_t read_descriptors_table(int fd,
                                struct descriptors_table* descriptors_table,
@@ -82,11 +75,22 @@ int free_descriptor(struct descriptors_table* descriptors_table,
                     uint16_t fd,
                     const struct superblock* superblock);
 
+/**
+ * @brief Check if inode is opened
+ * @param descriptors_table
+ * @param inode_id
+ * @param superblock
+ * @return true if some reserved descriptor points to inode
+ */
+bool is_inode_opened(const struct descriptors_table* descriptors_table,
+                     uint16_t inode_id,
+                     const struct superblock* superblock);
+
 /**
  * @brief Sizeof descriptors_table
  * @param superblock
  * @return
  */
-uint16_t sizeof_descriptors_table(const struct superblock* superblock);
+size_t sizeof_descriptors_table(const struct superblock* superblock);
 
 #endif //EXT_FILESYSTEM_CORE_DESCRIPTORS_TABLE_H_
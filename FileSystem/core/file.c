@@ -0,0 +1,1318 @@
+/** @author yaishenka
+    @date 19.10.2026 */
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include "file.h"
+#include "block.h"
+#include "layout.h"
+#include "lz.h"
+#include "arena.h"
+#include "../utils.h"
+
+uint16_t get_file_block_id(const struct inode* inode,
+                           const struct superblock* superblock,
+                           uint64_t block_index) {
+  uint16_t hole_id = superblock->fs_info->blocks_count;
+  uint16_t cluster_size = get_inode_cluster_size(inode, superblock);
+  uint64_t entry = block_index / cluster_size;
+  if (entry >= inode->inode_info->blocks_count
+      || inode->block_ids[entry] == hole_id) {
+    return hole_id;
+  }
+
+  return inode->block_ids[entry] + block_index % cluster_size;
+}
+
+bool is_hole_block(const struct inode* inode,
+                   const struct superblock* superblock,
+                   uint64_t block_index) {
+  return get_file_block_id(inode, superblock, block_index)
+      == superblock->fs_info->blocks_count;
+}
+
+bool is_data_block(const struct inode* inode,
+                   const struct superblock* superblock,
+                   uint64_t block_index) {
+  uint16_t block_id = get_file_block_id(inode, superblock, block_index);
+  return block_id != superblock->fs_info->blocks_count
+      && !superblock->unwritten_blocks_mask[block_id];
+}
+
+uint16_t get_data_blocks_count(const struct inode* inode,
+                               const struct superblock* superblock) {
+  uint16_t blocks_count = inode->inode_info->blocks_count
+      * get_inode_cluster_size(inode, superblock);
+  while (blocks_count > 0
+      && !is_data_block(inode, superblock, blocks_count - 1)) {
+    --blocks_count;
+  }
+
+  return blocks_count;
+}
+
+bool is_tail_block(const struct inode* inode,
+                   const struct superblock* superblock,
+                   uint64_t block_index) {
+  return is_tail_inode(inode)
+      && block_index + 1 == inode->inode_info->blocks_count
+      && !is_hole_block(inode, superblock, block_index);
+}
+
+uint64_t get_inode_data_size(const struct inode* inode) {
+  return inode->inode_info->size;
+}
+
+ssize_t read_cluster_data(const int fd,
+                          const struct inode* inode,
+                          const struct superblock* superblock,
+                          uint64_t position,
+                          char* dest,
+                          uint64_t size) {
+  uint16_t cluster_size = get_cluster_size(superblock);
+  uint32_t max_data_in_block = get_max_data_in_block(superblock);
+  size_t block_size = sizeof_block(superblock);
+  char* records = (char*) arena_calloc((size_t) cluster_size * block_size,
+                                       sizeof(char));
+  uint64_t total_read = 0;
+  while (total_read != size) {
+    uint64_t block_index = get_block_index(superblock, position);
+    uint64_t cluster_end =
+        (block_index - block_index % cluster_size + cluster_size)
+            * max_data_in_block;
+    uint64_t size_to_read = cluster_end - position;
+    if (size_to_read > size - total_read) {
+      size_to_read = size - total_read;
+    }
+
+    if (is_hole_block(inode, superblock, block_index)) {
+      memset(dest, 0, size_to_read);
+    } else {
+      uint16_t first_block_id =
+          get_file_block_id(inode, superblock, block_index);
+      uint16_t count = get_block_index(superblock,
+                                       position + size_to_read - 1)
+          - block_index + 1;
+      if (read_blocks_run(fd, superblock, first_block_id, count, records)
+          == -1) {
+        fprintf(stderr, "Can't read blocks. Abort!\n");
+        return -1;
+      }
+
+      uint64_t copied = 0;
+      for (uint16_t i = 0; i < count; ++i) {
+        const char* record = records + i * block_size;
+        uint32_t position_in_block =
+            get_position_in_block(superblock, position + copied);
+        uint32_t chunk = max_data_in_block - position_in_block;
+        if (chunk > size_to_read - copied) {
+          chunk = size_to_read - copied;
+        }
+
+        if (superblock->unwritten_blocks_mask[first_block_id + i]) {
+          memset(dest + copied, 0, chunk);
+        } else if (!is_record_checksum_valid(record, block_size)) {
+          fprintf(stderr, "Block checksum mismatch!\n");
+          return -1;
+        } else {
+          memcpy(dest + copied,
+                 record + sizeof(struct block_info) + position_in_block,
+                 chunk);
+        }
+        copied += chunk;
+      }
+    }
+
+    position += size_to_read;
+    dest += size_to_read;
+    total_read += size_to_read;
+  }
+
+  return total_read;
+}
+
+ssize_t read_inode_data(const int fd,
+                        const struct inode* inode,
+                        const struct superblock* superblock,
+                        uint64_t position,
+                        char* dest,
+                        uint64_t size) {
+  uint64_t data_size = get_inode_data_size(inode);
+  if (position >= data_size) {
+    return 0;
+  }
+
+  if (size > data_size - position) {
+    size = data_size - position;
+  }
+
+  if (is_inline_inode(inode)) {
+    memcpy(dest, get_inline_data(inode) + position, size);
+    return size;
+  }
+
+  if (is_compressed_inode(inode)) {
+    char* data = (char*) arena_calloc(
+        get_max_data_size_of_all_blocks(superblock), sizeof(char));
+    if (read_compressed_data(fd, inode, superblock, data) == -1) {
+      return -1;
+    }
+
+    memcpy(dest, data + position, size);
+    return size;
+  }
+
+  if (is_clustered_inode(inode)) {
+    return read_cluster_data(fd, inode, superblock, position, dest, size);
+  }
+
+  uint32_t max_data_in_block = get_max_data_in_block(superblock);
+  uint64_t total_read = 0;
+  while (total_read != size) {
+    uint64_t block_index = get_block_index(superblock, position);
+    uint32_t position_in_block = get_position_in_block(superblock, position);
+    uint32_t size_to_read = max_data_in_block - position_in_block;
+    if (size_to_read > size - total_read) {
+      size_to_read = size - total_read;
+    }
+
+    if (!is_data_block(inode, superblock, block_index)) {
+      memset(dest, 0, size_to_read);
+    } else {
+      struct block block;
+      if (read_block(fd, &block, inode->block_ids[block_index], superblock)
+          == -1) {
+        fprintf(stderr, "Can't read block. Abort!\n");
+        return -1;
+      }
+      uint32_t tail_offset = is_tail_block(inode, superblock, block_index)
+          ? inode->inode_info->tail_offset : 0;
+      memcpy(dest, block.data + tail_offset + position_in_block, size_to_read);
+    }
+
+    position += size_to_read;
+    dest += size_to_read;
+    total_read += size_to_read;
+  }
+
+  return total_read;
+}
+
+ssize_t write_inline_data(const int fd,
+                          struct inode* inode,
+                          const struct superblock* superblock,
+                          uint64_t position,
+                          const char* data,
+                          uint64_t size) {
+  memcpy(get_inline_data(inode) + position, data, size);
+  if (inode->inode_info->blocks_count < position + size) {
+    inode->inode_info->blocks_count = position + size;
+  }
+  if (inode->inode_info->size < position + size) {
+    inode->inode_info->size = position + size;
+  }
+  inode->inode_info->modified_time = time(NULL);
+
+  if (write_inode(fd, inode, superblock) == -1) {
+    fprintf(stderr, "Can't write inode. Abort!\n");
+    return -1;
+  }
+
+  return size;
+}
+
+ssize_t spill_inline_data(const int fd,
+                          struct inode* inode,
+                          const struct superblock* superblock) {
+  uint16_t inline_size = inode->inode_info->blocks_count;
+  char inline_data[INODE_RECORD_SIZE];
+  memcpy(inline_data, get_inline_data(inode), inline_size);
+
+  memset(get_inline_data(inode), 0, get_inline_capacity(superblock));
+  inode->inode_info->flags &= ~INODE_FLAG_INLINE;
+  inode->inode_info->blocks_count = 0;
+
+  if (inline_size == 0) {
+    return 0;
+  }
+
+  return write_inode_data(fd, inode, superblock, 0, inline_data, inline_size);
+}
+
+ssize_t read_compressed_data(const int fd,
+                             const struct inode* inode,
+                             const struct superblock* superblock,
+                             char* dest) {
+  uint32_t max_data_in_block = get_max_data_in_block(superblock);
+  char* extent = (char*) arena_calloc(
+      (size_t) inode->inode_info->blocks_count * max_data_in_block,
+      sizeof(char));
+  uint32_t extent_size = 0;
+
+  for (uint16_t index = 0; index < inode->inode_info->blocks_count; ++index) {
+    struct block block;
+    if (read_block(fd, &block, inode->block_ids[index], superblock) == -1) {
+      fprintf(stderr, "Can't read block. Abort!\n");
+      return -1;
+    }
+
+    memcpy(extent + extent_size, block.data, block.block_info->data_size);
+    extent_size += block.block_info->data_size;
+  }
+
+  uint32_t size;
+  memcpy(&size, extent, sizeof(uint32_t));
+  if (extent_size < sizeof(uint32_t)
+      || lz_decompress(extent + sizeof(uint32_t),
+                       extent_size - sizeof(uint32_t),
+                       dest,
+                       get_max_data_size_of_all_blocks(superblock)) != size) {
+    fprintf(stderr, "Compressed data is corrupted. Abort!\n");
+    return -1;
+  }
+
+  return size;
+}
+
+ssize_t expand_compressed_data(const int fd,
+                               struct inode* inode,
+                               const struct superblock* superblock) {
+  char* data = (char*) arena_calloc(
+      get_max_data_size_of_all_blocks(superblock), sizeof(char));
+  ssize_t size = read_compressed_data(fd, inode, superblock, data);
+  if (size == -1) {
+    return -1;
+  }
+
+  for (uint16_t index = 0; index < inode->inode_info->blocks_count; ++index) {
+    release_block(superblock, inode->block_ids[index]);
+  }
+  inode->inode_info->flags &= ~INODE_FLAG_COMPRESSED;
+  inode->inode_info->blocks_count = 0;
+
+  if (size == 0) {
+    return write_inode(fd, inode, superblock) == -1 ? -1 : 0;
+  }
+
+  return write_inode_data(fd, inode, superblock, 0, data, size);
+}
+
+ssize_t compress_inode_data(const int fd,
+                            struct inode* inode,
+                            const struct superblock* superblock) {
+  if (is_inline_inode(inode) || is_compressed_inode(inode)
+      || is_clustered_inode(inode) || is_tail_inode(inode)) {
+    return 0;
+  }
+
+  uint16_t stored_blocks = 0;
+  for (uint16_t index = 0; index < inode->inode_info->blocks_count; ++index) {
+    if (!is_hole_block(inode, superblock, index)) {
+      ++stored_blocks;
+    }
+  }
+
+  if (stored_blocks == 0) {
+    return 0;
+  }
+
+  uint32_t max_data_in_block = get_max_data_in_block(superblock);
+  size_t capacity = (size_t) (stored_blocks - 1) * max_data_in_block;
+  if (capacity <= sizeof(uint32_t)) {
+    return 0;
+  }
+
+  uint64_t size = get_inode_data_size(inode);
+  char* data = (char*) arena_calloc(size + 1, sizeof(char));
+  if (read_inode_data(fd, inode, superblock, 0, data, size) != (ssize_t) size) {
+    return -1;
+  }
+
+  char* extent = (char*) arena_calloc(capacity, sizeof(char));
+  uint32_t data_size = size;
+  memcpy(extent, &data_size, sizeof(uint32_t));
+  size_t compressed_size = lz_compress(data,
+                                       size,
+                                       extent + sizeof(uint32_t),
+                                       capacity - sizeof(uint32_t));
+  if (compressed_size == 0) {
+    return 0;
+  }
+
+  size_t extent_size = sizeof(uint32_t) + compressed_size;
+  uint16_t extent_blocks =
+      (extent_size + max_data_in_block - 1) / max_data_in_block;
+  uint16_t new_block_ids[BLOCKS_COUNT_IN_INODE];
+  uint16_t allocated = reserve_blocks(superblock, 0, extent_blocks, new_block_ids);
+  if (allocated != extent_blocks) {
+    for (uint16_t i = 0; i < allocated; ++i) {
+      free_block(superblock, new_block_ids[i]);
+    }
+    return 0;
+  }
+
+  for (uint16_t index = 0; index < extent_blocks; ++index) {
+    size_t offset = (size_t) index * max_data_in_block;
+    size_t chunk = extent_size - offset < max_data_in_block
+                   ? extent_size - offset : max_data_in_block;
+
+    struct block block;
+    init_block(&block, superblock, new_block_ids[index], inode->inode_info->id);
+    memcpy(block.data, extent + offset, chunk);
+    block.block_info->data_size = chunk;
+    if (write_block(fd, &block, superblock) == -1) {
+      fprintf(stderr, "Can't write block. Abort!\n");
+      for (uint16_t i = 0; i < allocated; ++i) {
+        free_block(superblock, new_block_ids[i]);
+      }
+      return -1;
+    }
+  }
+
+  for (uint16_t index = 0; index < inode->inode_info->blocks_count; ++index) {
+    if (!is_hole_block(inode, superblock, index)) {
+      release_block(superblock, inode->block_ids[index]);
+    }
+  }
+
+  memcpy(inode->block_ids, new_block_ids, extent_blocks * sizeof(uint16_t));
+  inode->inode_info->blocks_count = extent_blocks;
+  inode->inode_info->flags |= INODE_FLAG_COMPRESSED;
+
+  if (write_inode(fd, inode, superblock) == -1) {
+    fprintf(stderr, "Can't write inode. Abort!\n");
+    return -1;
+  }
+
+  return stored_blocks - extent_blocks;
+}
+
+ssize_t pack_tail_data(const int fd,
+                       struct inode* inode,
+                       const struct superblock* superblock) {
+  if (is_inline_inode(inode) || is_compressed_inode(inode)
+      || is_clustered_inode(inode) || is_tail_inode(inode)) {
+    return 0;
+  }
+
+  uint16_t blocks_count = inode->inode_info->blocks_count;
+  if (blocks_count == 0
+      || get_data_blocks_count(inode, superblock) != blocks_count) {
+    return 0;
+  }
+
+  uint32_t max_data_in_block = get_max_data_in_block(superblock);
+  uint64_t size = get_inode_data_size(inode);
+  uint64_t tail_position = (uint64_t) (blocks_count - 1) * max_data_in_block;
+  if (size <= tail_position
+      || size - tail_position >= max_data_in_block) {
+    return 0;
+  }
+
+  uint32_t tail_size = size - tail_position;
+  uint16_t old_block_id = inode->block_ids[blocks_count - 1];
+  struct block old_block;
+  if (read_block(fd, &old_block, old_block_id, superblock) == -1) {
+    fprintf(stderr, "Can't read block. Abort!\n");
+    return -1;
+  }
+
+  struct block tail_block;
+  uint16_t tail_block_id = find_tail_block(superblock, tail_size);
+  if (tail_block_id == superblock->fs_info->blocks_count) {
+    tail_block_id = compact_tail_block(fd, superblock, tail_size);
+  }
+  if (tail_block_id != superblock->fs_info->blocks_count) {
+    if (read_block(fd, &tail_block, tail_block_id, superblock) == -1) {
+      fprintf(stderr, "Can't read block. Abort!\n");
+      return -1;
+    }
+  } else if (!is_shared_block(superblock, old_block_id)) {
+    tail_block_id = old_block_id;
+    init_block(&tail_block,
+               superblock,
+               tail_block_id,
+               superblock->fs_info->inodes_count);
+    if (superblock->block_fingerprints != NULL) {
+      set_block_fingerprint(superblock, tail_block_id, 0);
+    }
+  } else {
+    return 0;
+  }
+
+  uint16_t tail_offset = tail_block.block_info->data_size;
+  memcpy(tail_block.data + tail_offset, old_block.data, tail_size);
+  tail_block.block_info->data_size += tail_size;
+  if (write_block(fd, &tail_block, superblock) == -1) {
+    fprintf(stderr, "Can't write block. Abort!\n");
+    return -1;
+  }
+
+  if (tail_block_id != old_block_id) {
+    superblock->block_references[tail_block_id] += 1;
+    release_block(superblock, old_block_id);
+  }
+  inode->block_ids[blocks_count - 1] = tail_block_id;
+  inode->inode_info->tail_offset = tail_offset;
+  inode->inode_info->flags |= INODE_FLAG_TAIL;
+
+  if (write_inode(fd, inode, superblock) == -1) {
+    fprintf(stderr, "Can't write inode. Abort!\n");
+    return -1;
+  }
+
+  return tail_size;
+}
+
+ssize_t unpack_tail_data(const int fd,
+                         struct inode* inode,
+                         const struct superblock* superblock) {
+  uint16_t index = inode->inode_info->blocks_count - 1;
+  uint64_t tail_position = (uint64_t) index * get_max_data_in_block(superblock);
+  uint64_t tail_size = get_inode_data_size(inode) - tail_position;
+  char* data = (char*) arena_calloc(tail_size + 1, sizeof(char));
+  if (read_inode_data(fd, inode, superblock, tail_position, data, tail_size)
+      != (ssize_t) tail_size) {
+    return -1;
+  }
+
+  release_block(superblock, inode->block_ids[index]);
+  inode->block_ids[index] = superblock->fs_info->blocks_count;
+  inode->inode_info->flags &= ~INODE_FLAG_TAIL;
+  inode->inode_info->tail_offset = 0;
+
+  return write_inode_data(fd, inode, superblock, tail_position, data, tail_size);
+}
+
+uint16_t compact_tail_block(const int fd,
+                            const struct superblock* superblock,
+                            uint32_t size) {
+  uint16_t blocks_count = superblock->fs_info->blocks_count;
+  uint16_t inodes_count = superblock->fs_info->inodes_count;
+  uint32_t max_data_in_block = get_max_data_in_block(superblock);
+  struct inode* inodes =
+      (struct inode*) arena_calloc(inodes_count, sizeof(struct inode));
+  bool* is_packed = (bool*) arena_calloc(inodes_count, sizeof(bool));
+  uint32_t* live_sizes =
+      (uint32_t*) arena_calloc(blocks_count, sizeof(uint32_t));
+  uint16_t* live_tails =
+      (uint16_t*) arena_calloc(blocks_count, sizeof(uint16_t));
+  for (uint16_t inode_id = 0; inode_id < inodes_count; ++inode_id) {
+    if (!superblock->reserved_inodes_mask[inode_id]) {
+      continue;
+    }
+
+    if (read_inode(fd, &inodes[inode_id], inode_id, superblock) == -1) {
+      fprintf(stderr, "Can't read inode. Abort!\n");
+      return blocks_count;
+    }
+
+    if (is_tail_inode(&inodes[inode_id])) {
+      uint16_t index = inodes[inode_id].inode_info->blocks_count - 1;
+      uint16_t block_id = inodes[inode_id].block_ids[index];
+      is_packed[inode_id] = true;
+      live_sizes[block_id] += get_inode_data_size(&inodes[inode_id])
+          - (uint64_t) index * max_data_in_block;
+      live_tails[block_id] += 1;
+    }
+  }
+
+  for (uint16_t block_id = 0; block_id < blocks_count; ++block_id) {
+    if (live_tails[block_id] == 0
+        || live_tails[block_id] != superblock->block_references[block_id] + 1
+        || superblock->block_references[block_id] == UINT8_MAX
+        || max_data_in_block - live_sizes[block_id] < size) {
+      continue;
+    }
+
+    struct block old_block;
+    if (read_block(fd, &old_block, block_id, superblock) == -1) {
+      fprintf(stderr, "Can't read block. Abort!\n");
+      return blocks_count;
+    }
+
+    if (old_block.block_info->data_size == live_sizes[block_id]) {
+      continue;
+    }
+
+    struct block tail_block;
+    init_block(&tail_block, superblock, block_id, inodes_count);
+    for (uint16_t inode_id = 0; inode_id < inodes_count; ++inode_id) {
+      struct inode* inode = &inodes[inode_id];
+      if (!is_packed[inode_id]) {
+        continue;
+      }
+
+      uint16_t index = inode->inode_info->blocks_count - 1;
+      if (inode->block_ids[index] != block_id) {
+        continue;
+      }
+
+      uint32_t tail_size = get_inode_data_size(inode)
+          - (uint64_t) index * max_data_in_block;
+      uint16_t tail_offset = tail_block.block_info->data_size;
+      memcpy(tail_block.data + tail_offset,
+             old_block.data + inode->inode_info->tail_offset,
+             tail_size);
+      tail_block.block_info->data_size += tail_size;
+      inode->inode_info->tail_offset = tail_offset;
+    }
+
+    if (write_block(fd, &tail_block, superblock) == -1) {
+      fprintf(stderr, "Can't write block. Abort!\n");
+      return blocks_count;
+    }
+
+    for (uint16_t inode_id = 0; inode_id < inodes_count; ++inode_id) {
+      struct inode* inode = &inodes[inode_id];
+      if (is_packed[inode_id]
+          && inode->block_ids[inode->inode_info->blocks_count - 1] == block_id
+          && write_inode(fd, inode, superblock) == -1) {
+        fprintf(stderr, "Can't write inode. Abort!\n");
+        return blocks_count;
+      }
+    }
+
+    return block_id;
+  }
+
+  return blocks_count;
+}
+
+uint32_t get_data_fingerprint(const struct block* block,
+                              const struct superblock* superblock) {
+  uint32_t fingerprint = crc32c(0,
+                                block->data,
+                                get_max_data_in_block(superblock));
+  fingerprint = crc32c(fingerprint,
+                       (const char*) &block->block_info->data_size,
+                       sizeof(uint16_t));
+  return fingerprint == 0 ? 1 : fingerprint;
+}
+
+uint16_t find_duplicate_block(const int fd,
+                              const struct superblock* superblock,
+                              const struct block* block,
+                              uint32_t fingerprint) {
+  uint16_t blocks_count = superblock->fs_info->blocks_count;
+  for (uint16_t block_id = get_fingerprint_bucket(superblock, fingerprint);
+       block_id != blocks_count;
+       block_id = get_next_in_bucket(superblock, block_id)) {
+    if (get_block_fingerprint(superblock, block_id) != fingerprint
+        || block_id == block->block_info->block_id
+        || !superblock->reserved_blocks_mask[block_id]
+        || superblock->unwritten_blocks_mask[block_id]
+        || superblock->block_references[block_id] == UINT8_MAX
+        || get_block_owner(superblock, block_id)
+            == superblock->fs_info->inodes_count) {
+      continue;
+    }
+
+    struct block candidate;
+    if (read_block(fd, &candidate, block_id, superblock) == -1) {
+      continue;
+    }
+
+    if (candidate.block_info->records_count == 0
+        && candidate.block_info->data_size == block->block_info->data_size
+        && memcmp(candidate.data,
+                  block->data,
+                  get_max_data_in_block(superblock)) == 0) {
+      return block_id;
+    }
+  }
+
+  return blocks_count;
+}
+
+ssize_t store_data_block(const int fd,
+                         struct inode* inode,
+                         const struct superblock* superblock,
+                         struct block* block,
+                         uint64_t block_index) {
+  if (superblock->block_fingerprints != NULL) {
+    uint32_t fingerprint = get_data_fingerprint(block, superblock);
+    uint16_t duplicate_id =
+        find_duplicate_block(fd, superblock, block, fingerprint);
+    if (duplicate_id != superblock->fs_info->blocks_count) {
+      release_block(superblock, block->block_info->block_id);
+      superblock->block_references[duplicate_id] += 1;
+      inode->block_ids[block_index] = duplicate_id;
+      return 0;
+    }
+    set_block_fingerprint(superblock, block->block_info->block_id, fingerprint);
+  }
+
+  if (write_block(fd, block, superblock) == -1) {
+    fprintf(stderr, "Can't write block. Abort!\n");
+    return -1;
+  }
+  inode->block_ids[block_index] = block->block_info->block_id;
+  return superblock->fs_info->block_size;
+}
+
+bool needs_new_block(const struct inode* inode,
+                     const struct superblock* superblock,
+                     uint64_t block_index,
+                     bool is_last,
+                     const char* data,
+                     uint64_t size) {
+  if (!is_hole_block(inode, superblock, block_index)) {
+    return is_shared_block(superblock, inode->block_ids[block_index]);
+  }
+
+  return is_last || !is_zero_memory(data, size);
+}
+
+uint16_t count_blocks_to_allocate(const struct inode* inode,
+                                  const struct superblock* superblock,
+                                  uint64_t position,
+                                  const char* data,
+                                  uint64_t size,
+                                  uint64_t last_index) {
+  uint32_t max_data_in_block = get_max_data_in_block(superblock);
+  uint16_t blocks_to_allocate = 0;
+
+  for (uint64_t total = 0; total != size;) {
+    uint64_t block_index = get_block_index(superblock, position + total);
+    if (block_index >= superblock->fs_info->blocks_count_in_inode) {
+      break;
+    }
+
+    uint32_t size_to_write =
+        max_data_in_block - get_position_in_block(superblock, position + total);
+    if (size_to_write > size - total) {
+      size_to_write = size - total;
+    }
+
+    if (needs_new_block(inode,
+                        superblock,
+                        block_index,
+                        block_index == last_index,
+                        data + total,
+                        size_to_write)) {
+      ++blocks_to_allocate;
+    }
+    total += size_to_write;
+  }
+
+  return blocks_to_allocate;
+}
+
+uint16_t get_allocation_goal(const struct inode* inode,
+                             const struct superblock* superblock) {
+  uint16_t hole_id = superblock->fs_info->blocks_count;
+  for (uint16_t index = inode->inode_info->blocks_count; index > 0; --index) {
+    if (inode->block_ids[index - 1] != hole_id) {
+      return inode->block_ids[index - 1]
+          + get_inode_cluster_size(inode, superblock);
+    }
+  }
+
+  return 0;
+}
+
+/**
+ * @brief Read run of blocks and verify checksums of written ones
+ * Unwritten blocks have no data on disk, so they aren't verified
+ * @return true if all ok; false otherwise
+ */
+static bool read_written_blocks(const int fd,
+                                const struct superblock* superblock,
+                                uint16_t first_block_id,
+                                uint16_t count,
+                                char* records) {
+  if (read_blocks_run(fd, superblock, first_block_id, count, records) == -1) {
+    fprintf(stderr, "Can't read blocks. Abort!\n");
+    return false;
+  }
+
+  size_t block_size = sizeof_block(superblock);
+  for (uint16_t i = 0; i < count; ++i) {
+    if (!superblock->unwritten_blocks_mask[first_block_id + i]
+        && !is_record_checksum_valid(records + i * block_size, block_size)) {
+      fprintf(stderr, "Block checksum mismatch!\n");
+      return false;
+    }
+  }
+
+  return true;
+}
+
+bool prepare_cluster(const int fd,
+                     struct inode* inode,
+                     const struct superblock* superblock,
+                     uint16_t entry) {
+  uint16_t hole_id = superblock->fs_info->blocks_count;
+  uint16_t cluster_size = get_cluster_size(superblock);
+  for (uint16_t index = inode->inode_info->blocks_count; index <= entry;
+       ++index) {
+    inode->block_ids[index] = hole_id;
+  }
+  if (inode->inode_info->blocks_count <= entry) {
+    inode->inode_info->blocks_count = entry + 1;
+  }
+
+  uint16_t old_block_id = inode->block_ids[entry];
+  if (old_block_id != hole_id) {
+    bool is_shared = false;
+    for (uint16_t i = 0; i < cluster_size; ++i) {
+      is_shared |= is_shared_block(superblock, old_block_id + i);
+    }
+
+    if (!is_shared) {
+      return true;
+    }
+  }
+
+  size_t block_size = sizeof_block(superblock);
+  char* records = (char*) arena_calloc((size_t) cluster_size * block_size,
+                                       sizeof(char));
+  if (old_block_id != hole_id
+      && !read_written_blocks(fd,
+                              superblock,
+                              old_block_id,
+                              cluster_size,
+                              records)) {
+    return false;
+  }
+
+  uint16_t new_block_id =
+      reserve_cluster(superblock, get_allocation_goal(inode, superblock));
+  if (new_block_id == hole_id) {
+    fprintf(stderr, "Can't create more blocks in FS. Abort!\n");
+    return false;
+  }
+
+  if (old_block_id == hole_id) {
+    for (uint16_t i = 0; i < cluster_size; ++i) {
+      superblock->unwritten_blocks_mask[new_block_id + i] = true;
+    }
+    inode->block_ids[entry] = new_block_id;
+    return true;
+  }
+
+  for (uint16_t i = 0; i < cluster_size; ++i) {
+    struct block_info* block_info =
+        (struct block_info*) (records + i * block_size);
+    block_info->block_id = new_block_id + i;
+    block_info->inode_id = inode->inode_info->id;
+    superblock->unwritten_blocks_mask[new_block_id + i] =
+        superblock->unwritten_blocks_mask[old_block_id + i];
+  }
+
+  if (write_blocks_run(fd, superblock, new_block_id, cluster_size, records)
+      == -1) {
+    fprintf(stderr, "Can't write blocks. Abort!\n");
+    return false;
+  }
+
+  for (uint16_t i = 0; i < cluster_size; ++i) {
+    release_block(superblock, old_block_id + i);
+  }
+  inode->block_ids[entry] = new_block_id;
+  return true;
+}
+
+ssize_t write_cluster_data(const int fd,
+                           struct inode* inode,
+                           const struct superblock* superblock,
+                           uint64_t position,
+                           const char* data,
+                           uint64_t size) {
+  uint16_t cluster_size = get_cluster_size(superblock);
+  uint32_t max_data_in_block = get_max_data_in_block(superblock);
+  uint64_t max_blocks_count =
+      (uint64_t) superblock->fs_info->blocks_count_in_inode * cluster_size;
+  size_t block_size = sizeof_block(superblock);
+  char* records = (char*) arena_calloc((size_t) cluster_size * block_size,
+                                       sizeof(char));
+  uint64_t total_written = 0;
+
+  while (total_written != size) {
+    uint64_t block_index = get_block_index(superblock, position);
+    if (block_index >= max_blocks_count) {
+      fprintf(stderr, "Can't create more blocks in this inode. Abort!\n");
+      break;
+    }
+
+    uint64_t cluster_end =
+        (block_index - block_index % cluster_size + cluster_size)
+            * max_data_in_block;
+    uint64_t size_to_write = cluster_end - position;
+    if (size_to_write > size - total_written) {
+      size_to_write = size - total_written;
+    }
+
+    bool is_last = total_written + size_to_write == size;
+    if (is_hole_block(inode, superblock, block_index) && !is_last
+        && is_zero_memory(data, size_to_write)) {
+      position += size_to_write;
+      data += size_to_write;
+      total_written += size_to_write;
+      continue;
+    }
+
+    if (!prepare_cluster(fd, inode, superblock, block_index / cluster_size)) {
+      break;
+    }
+
+    uint16_t first_block_id = get_file_block_id(inode, superblock, block_index);
+    uint16_t count = get_block_index(superblock, position + size_to_write - 1)
+        - block_index + 1;
+    bool has_data = false;
+    for (uint16_t i = 0; i < count; ++i) {
+      has_data |= !superblock->unwritten_blocks_mask[first_block_id + i];
+    }
+
+    if (has_data
+        && !read_written_blocks(fd, superblock, first_block_id, count, records)) {
+      return -1;
+    }
+
+    uint64_t copied = 0;
+    for (uint16_t i = 0; i < count; ++i) {
+      char* record = records + i * block_size;
+      struct block_info* block_info = (struct block_info*) record;
+      uint32_t position_in_block =
+          get_position_in_block(superblock, position + copied);
+      uint32_t chunk = max_data_in_block - position_in_block;
+      if (chunk > size_to_write - copied) {
+        chunk = size_to_write - copied;
+      }
+
+      if (superblock->unwritten_blocks_mask[first_block_id + i]) {
+        memset(record, 0, block_size);
+        block_info->block_id = first_block_id + i;
+        block_info->inode_id = inode->inode_info->id;
+        superblock->unwritten_blocks_mask[first_block_id + i] = false;
+      }
+
+      memcpy(record + sizeof(struct block_info) + position_in_block,
+             data + copied,
+             chunk);
+      if (block_info->data_size < position_in_block + chunk) {
+        block_info->data_size = position_in_block + chunk;
+      }
+      copied += chunk;
+    }
+
+    if (write_blocks_run(fd, superblock, first_block_id, count, records)
+        == -1) {
+      fprintf(stderr, "Can't write blocks. Abort!\n");
+      return -1;
+    }
+
+    position += size_to_write;
+    data += size_to_write;
+    total_written += size_to_write;
+  }
+
+  if (inode->inode_info->size < position) {
+    inode->inode_info->size = position;
+  }
+  inode->inode_info->modified_time = time(NULL);
+
+  if (write_inode(fd, inode, superblock) == -1) {
+    fprintf(stderr, "Can't write inode. Abort!\n");
+    return -1;
+  }
+
+  return total_written;
+}
+
+ssize_t convert_to_clusters(const int fd,
+                            struct inode* inode,
+                            const struct superblock* superblock) {
+  uint64_t size = get_inode_data_size(inode);
+  char* data = (char*) arena_calloc(size + 1, sizeof(char));
+  if (read_inode_data(fd, inode, superblock, 0, data, size) != (ssize_t) size) {
+    return -1;
+  }
+
+  for (uint16_t index = 0; index < inode->inode_info->blocks_count; ++index) {
+    if (!is_hole_block(inode, superblock, index)) {
+      release_block(superblock, inode->block_ids[index]);
+    }
+  }
+  inode->inode_info->flags |= INODE_FLAG_CLUSTERS;
+  inode->inode_info->blocks_count = 0;
+
+  if (size == 0) {
+    return write_inode(fd, inode, superblock) == -1 ? -1 : 0;
+  }
+
+  return write_cluster_data(fd, inode, superblock, 0, data, size);
+}
+
+bool needs_clusters(const struct inode* inode,
+                    const struct superblock* superblock,
+                    uint64_t blocks_count) {
+  return (superblock->fs_info->flags & FS_FLAG_BIGALLOC)
+      && !is_clustered_inode(inode)
+      && blocks_count > superblock->fs_info->blocks_count_in_inode;
+}
+
+ssize_t write_inode_data(const int fd,
+                         struct inode* inode,
+                         const struct superblock* superblock,
+                         uint64_t position,
+                         const char* data,
+                         uint64_t size) {
+  uint16_t hole_id = superblock->fs_info->blocks_count;
+  uint32_t max_data_in_block = get_max_data_in_block(superblock);
+  uint64_t total_written = 0;
+  if (size == 0) {
+    return 0;
+  }
+
+  if (is_inline_inode(inode)) {
+    if (position + size <= get_inline_capacity(superblock)) {
+      return write_inline_data(fd, inode, superblock, position, data, size);
+    }
+
+    if (spill_inline_data(fd, inode, superblock) == -1) {
+      fprintf(stderr, "Can't move inline data to blocks. Abort!\n");
+      return -1;
+    }
+  }
+
+  if (is_compressed_inode(inode)
+      && expand_compressed_data(fd, inode, superblock) == -1) {
+    fprintf(stderr, "Can't expand compressed data. Abort!\n");
+    return -1;
+  }
+
+  if (is_tail_inode(inode)
+      && unpack_tail_data(fd, inode, superblock) == -1) {
+    fprintf(stderr, "Can't unpack tail. Abort!\n");
+    return -1;
+  }
+
+  if (needs_clusters(inode,
+                     superblock,
+                     get_block_index(superblock, position + size - 1) + 1)
+      && convert_to_clusters(fd, inode, superblock) == -1) {
+    fprintf(stderr, "Can't move data to clusters. Abort!\n");
+    return -1;
+  }
+
+  if (is_clustered_inode(inode)) {
+    return write_cluster_data(fd, inode, superblock, position, data, size);
+  }
+
+  uint16_t old_blocks_count = get_data_blocks_count(inode, superblock);
+  uint64_t last_index = get_block_index(superblock, position + size - 1);
+  if (last_index >= superblock->fs_info->blocks_count_in_inode) {
+    last_index = superblock->fs_info->blocks_count_in_inode - 1;
+  }
+  if (last_index + 1 < old_blocks_count) {
+    last_index = old_blocks_count - 1;
+  }
+
+  uint16_t new_block_ids[BLOCKS_COUNT_IN_INODE];
+  uint16_t blocks_to_allocate = count_blocks_to_allocate(inode,
+                                                         superblock,
+                                                         position,
+                                                         data,
+                                                         size,
+                                                         last_index);
+  uint16_t allocated = reserve_blocks(superblock,
+                                      get_allocation_goal(inode, superblock),
+                                      blocks_to_allocate,
+                                      new_block_ids);
+  uint16_t used_new_blocks = 0;
+
+  while (total_written != size) {
+    uint64_t block_index = get_block_index(superblock, position);
+    if (block_index >= superblock->fs_info->blocks_count_in_inode) {
+      fprintf(stderr, "Can't create more blocks in this inode. Abort!\n");
+      break;
+    }
+
+    uint32_t position_in_block = get_position_in_block(superblock, position);
+    uint32_t size_to_write = max_data_in_block - position_in_block;
+    if (size_to_write > size - total_written) {
+      size_to_write = size - total_written;
+    }
+
+    uint16_t blocks_count = inode->inode_info->blocks_count;
+    bool is_last = block_index == last_index;
+    bool is_stored = !is_hole_block(inode, superblock, block_index);
+    bool is_unwritten = is_stored
+        && superblock->unwritten_blocks_mask[inode->block_ids[block_index]];
+
+    struct block block;
+    if (is_unwritten) {
+      uint16_t block_id = inode->block_ids[block_index];
+      if (!is_last && is_zero_memory(data, size_to_write)) {
+        position += size_to_write;
+        data += size_to_write;
+        total_written += size_to_write;
+        continue;
+      }
+
+      if (is_shared_block(superblock, block_id)) {
+        if (used_new_blocks == allocated) {
+          fprintf(stderr, "Can't create more blocks in FS. Abort!\n");
+          break;
+        }
+        release_block(superblock, block_id);
+        block_id = new_block_ids[used_new_blocks++];
+      } else {
+        superblock->unwritten_blocks_mask[block_id] = false;
+      }
+      init_block(&block, superblock, block_id, inode->inode_info->id);
+    } else if (is_stored) {
+      uint16_t block_id = inode->block_ids[block_index];
+      if (read_block(fd, &block, block_id, superblock) == -1) {
+        fprintf(stderr, "Can't read block. Abort!\n");
+        return -1;
+      }
+
+      if (is_shared_block(superblock, block_id)) {
+        if (used_new_blocks == allocated) {
+          fprintf(stderr, "Can't create more blocks in FS. Abort!\n");
+          break;
+        }
+        release_block(superblock, block_id);
+        block.block_info->block_id = new_block_ids[used_new_blocks++];
+        block.block_info->inode_id = inode->inode_info->id;
+      }
+    } else if (needs_new_block(inode,
+                               superblock,
+                               block_index,
+                               is_last,
+                               data,
+                               size_to_write)) {
+      if (used_new_blocks == allocated) {
+        fprintf(stderr, "Can't create more blocks in FS. Abort!\n");
+        break;
+      }
+      init_block(&block,
+                 superblock,
+                 new_block_ids[used_new_blocks++],
+                 inode->inode_info->id);
+    } else {
+      position += size_to_write;
+      data += size_to_write;
+      total_written += size_to_write;
+      continue;
+    }
+
+    memcpy(block.data + position_in_block, data, size_to_write);
+    if (block.block_info->data_size < position_in_block + size_to_write) {
+      block.block_info->data_size = position_in_block + size_to_write;
+    }
+
+    for (; blocks_count < block_index; ++blocks_count) {
+      inode->block_ids[blocks_count] = hole_id;
+    }
+    if (blocks_count == block_index) {
+      inode->inode_info->blocks_count = block_index + 1;
+    }
+
+    if (is_stored && !is_last
+        && is_zero_memory(block.data, max_data_in_block)) {
+      release_block(superblock, block.block_info->block_id);
+      inode->block_ids[block_index] = hole_id;
+    } else if (store_data_block(fd, inode, superblock, &block, block_index)
+        == -1) {
+      return -1;
+    }
+
+    position += size_to_write;
+    data += size_to_write;
+    total_written += size_to_write;
+  }
+
+  for (; used_new_blocks < allocated; ++used_new_blocks) {
+    free_block(superblock, new_block_ids[used_new_blocks]);
+  }
+
+  if (old_blocks_count != 0
+      && old_blocks_count < get_data_blocks_count(inode, superblock)
+      && is_data_block(inode, superblock, old_blocks_count - 1)) {
+    struct block block;
+    if (read_block(fd,
+                   &block,
+                   inode->block_ids[old_blocks_count - 1],
+                   superblock) == -1) {
+      fprintf(stderr, "Can't read block. Abort!\n");
+      return -1;
+    }
+
+    if (is_zero_memory(block.data, max_data_in_block)) {
+      release_block(superblock, block.block_info->block_id);
+      inode->block_ids[old_blocks_count - 1] = hole_id;
+    }
+  }
+
+  if (inode->inode_info->size < position) {
+    inode->inode_info->size = position;
+  }
+  inode->inode_info->modified_time = time(NULL);
+
+  if (write_inode(fd, inode, superblock) == -1) {
+    fprintf(stderr, "Can't write inode. Abort!\n");
+    return -1;
+  }
+
+  return total_written;
+}
+
+ssize_t seek_inode_data(const struct inode* inode,
+                        const struct superblock* superblock,
+                        uint64_t position,
+                        int whence) {
+  uint64_t data_size = get_inode_data_size(inode);
+  if (whence == LSEEK_END) {
+    if (position > INT64_MAX - data_size) {
+      fprintf(stderr, "Position is out of file. Abort!\n");
+      return -1;
+    }
+    return data_size + position;
+  }
+
+  if (position >= data_size) {
+    fprintf(stderr, "Position is out of file. Abort!\n");
+    return -1;
+  }
+
+  if (is_inline_inode(inode) || is_compressed_inode(inode)) {
+    return whence == LSEEK_HOLE ? data_size : position;
+  }
+
+  bool looking_for_hole = whence == LSEEK_HOLE;
+  uint64_t block_index = get_block_index(superblock, position);
+  while (block_index < get_data_blocks_count(inode, superblock)
+      && is_data_block(inode, superblock, block_index) == looking_for_hole) {
+    ++block_index;
+  }
+
+  uint64_t found = (uint64_t) block_index * get_max_data_in_block(superblock);
+  if (found < position) {
+    found = position;
+  }
+
+  return found < data_size ? found : data_size;
+}
+
+ssize_t allocate_clusters(const int fd,
+                          struct inode* inode,
+                          const struct superblock* superblock,
+                          uint64_t blocks_count) {
+  uint16_t cluster_size = get_cluster_size(superblock);
+  uint64_t clusters_count = (blocks_count + cluster_size - 1) / cluster_size;
+  if (clusters_count > superblock->fs_info->blocks_count_in_inode) {
+    fprintf(stderr, "Can't create more blocks in this inode. Abort!\n");
+    return -1;
+  }
+
+  ssize_t reserved = 0;
+  for (uint16_t entry = 0; entry < clusters_count; ++entry) {
+    if (!is_hole_block(inode, superblock, (uint64_t) entry * cluster_size)) {
+      continue;
+    }
+
+    if (!prepare_cluster(fd, inode, superblock, entry)) {
+      return -1;
+    }
+    reserved += cluster_size;
+  }
+
+  if (write_inode(fd, inode, superblock) == -1) {
+    fprintf(stderr, "Can't write inode. Abort!\n");
+    return -1;
+  }
+
+  return reserved;
+}
+
+ssize_t allocate_inode_data(const int fd,
+                            struct inode* inode,
+                            const struct superblock* superblock,
+                            uint64_t size) {
+  if (is_inline_inode(inode)) {
+    if (size <= get_inline_capacity(superblock)) {
+      return 0;
+    }
+
+    if (spill_inline_data(fd, inode, superblock) == -1) {
+      fprintf(stderr, "Can't move inline data to blocks. Abort!\n");
+      return -1;
+    }
+  }
+
+  if (is_compressed_inode(inode)
+      && expand_compressed_data(fd, inode, superblock) == -1) {
+    fprintf(stderr, "Can't expand compressed data. Abort!\n");
+    return -1;
+  }
+
+  if (is_tail_inode(inode)
+      && unpack_tail_data(fd, inode, superblock) == -1) {
+    fprintf(stderr, "Can't unpack tail. Abort!\n");
+    return -1;
+  }
+
+  uint32_t max_data_in_block = get_max_data_in_block(superblock);
+  uint64_t blocks_count = (size + max_data_in_block - 1) / max_data_in_block;
+  if (needs_clusters(inode, superblock, blocks_count)
+      && convert_to_clusters(fd, inode, superblock) == -1) {
+    fprintf(stderr, "Can't move data to clusters. Abort!\n");
+    return -1;
+  }
+
+  if (is_clustered_inode(inode)) {
+    return allocate_clusters(fd, inode, superblock, blocks_count);
+  }
+
+  if (blocks_count > superblock->fs_info->blocks_count_in_inode) {
+    fprintf(stderr, "Can't create more blocks in this inode. Abort!\n");
+    return -1;
+  }
+
+  uint16_t holes_count = 0;
+  for (uint64_t index = 0; index < blocks_count; ++index) {
+    if (is_hole_block(inode, superblock, index)) {
+      ++holes_count;
+    }
+  }
+
+  uint16_t new_block_ids[BLOCKS_COUNT_IN_INODE];
+  uint16_t allocated = reserve_blocks(superblock,
+                                      get_allocation_goal(inode, superblock),
+                                      holes_count,
+                                      new_block_ids);
+  if (allocated != holes_count) {
+    fprintf(stderr, "Can't create more blocks in FS. Abort!\n");
+    for (uint16_t i = 0; i < allocated; ++i) {
+      free_block(superblock, new_block_ids[i]);
+    }
+    return -1;
+  }
+
+  uint16_t used_new_blocks = 0;
+  for (uint64_t index = 0; index < blocks_count; ++index) {
+    if (!is_hole_block(inode, superblock, index)) {
+      continue;
+    }
+
+    uint16_t new_block_id = new_block_ids[used_new_blocks++];
+    superblock->unwritten_blocks_mask[new_block_id] = true;
+    inode->block_ids[index] = new_block_id;
+  }
+
+  if (inode->inode_info->blocks_count < blocks_count) {
+    inode->inode_info->blocks_count = blocks_count;
+  }
+
+  if (write_inode(fd, inode, superblock) == -1) {
+    fprintf(stderr, "Can't write inode. Abort!\n");
+    return -1;
+  }
+
+  return allocated;
+}
@@ -0,0 +1,274 @@
+/**
+ * @file file.h
+ * @author yaishenka
+ * @date 19.10.2026
+ * @brief Contains methods to work with data of file
+ *
+ * Files are sparse: block_ids entry equal to blocks_count is a hole.
+ * Hole reads back as zeros and has no block in FS.
+ * Blocks reserved by allocate_inode_data() are unwritten
+ * (see superblock->unwritten_blocks_mask): they are read as zeros too.
+ * Size of file is stored in inode (see inode_info->size) and is updated by
+ * writes. Last data block of file is always stored.
+ * Small files are stored inline in inode (see INODE_FLAG_INLINE) and
+ * are moved to blocks when they outgrow get_inline_capacity().
+ * With FS_FLAG_BIGALLOC file which outgrows blocks_count_in_inode blocks is
+ * moved to clusters (see INODE_FLAG_CLUSTERS): it is allocated, read and
+ * written by whole runs of blocks of cluster. Blocks of cluster which weren't
+ * written yet are unwritten.
+ * With FS_FLAG_TAILPACK last partial block of closed file is packed with
+ * tails of other files in shared tail block (see INODE_FLAG_TAIL) and is
+ * unpacked back on next write.
+ */
+#ifndef EXT_FILESYSTEM_CORE_FILE_H_
+#define EXT_FILESYSTEM_CORE_FILE_H_
+#include <stdint.h>
+#include <stdbool.h>
+#include <unistd.h>
+#include "superblock.h"
+#include "inode.h"
+
+#define LSEEK_SET 0
+#define LSEEK_DATA 1
+#define LSEEK_HOLE 2
+#define LSEEK_END 3
+
+/**
+ * @brief Map block of file to block of FS
+ * @param inode
+ * @param superblock
+ * @param block_index index of block in file
+ * @return id of block; superblock->fs_info->blocks_count if block is hole
+ */
+uint16_t get_file_block_id(const struct inode* inode,
+                           const struct superblock* superblock,
+                           uint64_t block_index);
+
+/**
+ * @brief Check if block of file is hole
+ * @param inode
+ * @param superblock
+ * @param block_index index of block in file
+ * @return true if block isn't stored
+ */
+bool is_hole_block(const struct inode* inode,
+                   const struct superblock* superblock,
+                   uint64_t block_index);
+
+/**
+ * @brief Check if block of file is stored and written
+ * @param inode
+ * @param superblock
+ * @param block_index index of block in file
+ * @return true if block has data
+ */
+bool is_data_block(const struct inode* inode,
+                   const struct superblock* superblock,
+                   uint64_t block_index);
+
+/**
+ * @brief Count blocks of file till last data block
+ * Unwritten blocks after end of file are not counted
+ * @param inode
+ * @param superblock
+ * @return index of last data block + 1; 0 if there is no data blocks
+ */
+uint16_t get_data_blocks_count(const struct inode* inode,
+                               const struct superblock* superblock);
+
+/**
+ * @brief Get size of file data
+ * Size is stored in inode, so nothing is read
+ * @param inode
+ * @return size of file in bytes
+ */
+uint64_t get_inode_data_size(const struct inode* inode);
+
+/**
+ * @brief Read data of file
+ * Holes are read as zeros. Reading stops at end of file
+ * @param fd opened fd
+ * @param inode
+ * @param superblock
+ * @param position
+ * @param dest buffer with at least size bytes
+ * @param size
+ * @return count of readed bytes if all ok; -1 otherwise
+ */
+ssize_t read_inode_data(int fd,
+                        const struct inode* inode,
+                        const struct superblock* superblock,
+                        uint64_t position,
+                        char* dest,
+                        uint64_t size);
+
+/**
+ * @brief Write data of inline file
+ * @param fd opened fd
+ * @param inode inline inode
+ * @param superblock
+ * @param position
+ * @param data
+ * @param size position + size should be \leq get_inline_capacity()
+ * @return count of written bytes if all ok; -1 otherwise
+ */
+ssize_t write_inline_data(int fd,
+                          struct inode* inode,
+                          const struct superblock* superblock,
+                          uint64_t position,
+                          const char* data,
+                          uint64_t size);
+
+/**
+ * @brief Move inline data of inode to blocks
+ * @param fd opened fd
+ * @param inode inline inode
+ * @param superblock
+ * @return count of moved bytes if all ok; -1 otherwise
+ */
+ssize_t spill_inline_data(int fd,
+                          struct inode* inode,
+                          const struct superblock* superblock);
+
+/**
+ * @brief Read and decompress data of compressed inode
+ * @param fd opened fd
+ * @param inode compressed inode
+ * @param superblock
+ * @param dest buffer of get_max_data_size_of_all_blocks() bytes
+ * @return size of data if all ok; -1 otherwise
+ */
+ssize_t read_compressed_data(int fd,
+                             const struct inode* inode,
+                             const struct superblock* superblock,
+                             char* dest);
+
+/**
+ * @brief Replace compressed extent of inode with plain blocks
+ * @param fd opened fd
+ * @param inode compressed inode
+ * @param superblock
+ * @return count of moved bytes if all ok; -1 otherwise
+ */
+ssize_t expand_compressed_data(int fd,
+                               struct inode* inode,
+                               const struct superblock* superblock);
+
+/**
+ * @brief Compress data of file into one extent
+ * Extent is stored only if it takes less blocks than file does now.
+ * Clustered files aren't compressed.
+ * Writes blocks and inode, superblock should be written by caller
+ * @param fd opened fd
+ * @param inode
+ * @param superblock
+ * @return count of saved blocks if all ok; -1 otherwise
+ */
+ssize_t compress_inode_data(int fd,
+                            struct inode* inode,
+                            const struct superblock* superblock);
+
+/**
+ * @brief Squeeze out tails of released files from tail block
+ * Tails of removed or unpacked files stay in tail block, so it is compacted
+ * when no tail block has enough free space. Only blocks which aren't shared
+ * with snapshots are compacted, as their inodes keep old tail offsets.
+ * All inodes are read, so it is done only when packing can't append
+ * @param fd opened fd
+ * @param superblock
+ * @param size size of tail to pack
+ * @return id of compacted tail block with at least size free bytes if all ok;
+ * superblock->fs_info->blocks_count otherwise
+ */
+uint16_t compact_tail_block(int fd,
+                            const struct superblock* superblock,
+                            uint32_t size);
+
+/**
+ * @brief Pack last partial block of file into tail block
+ * Tail is appended to first tail block with enough free space
+ * (see find_tail_block()), tail block with released space is compacted
+ * otherwise (see compact_tail_block()). If there is no such block, last block
+ * of file becomes new tail block. Inline, compressed and clustered files aren't packed.
+ * Writes blocks and inode, superblock should be written by caller
+ * @param fd opened fd
+ * @param inode
+ * @param superblock
+ * @return size of packed tail if all ok; -1 otherwise
+ */
+ssize_t pack_tail_data(int fd,
+                       struct inode* inode,
+                       const struct superblock* superblock);
+
+/**
+ * @brief Move tail of file from tail block back to its own block
+ * @param fd opened fd
+ * @param inode tail packed inode
+ * @param superblock
+ * @return count of moved bytes if all ok; -1 otherwise
+ */
+ssize_t unpack_tail_data(int fd,
+                         struct inode* inode,
+                         const struct superblock* superblock);
+
+/**
+ * @brief Write data to file
+ * Inline file is written in place while it fits in inode.
+ * Compressed file is expanded to plain blocks first, tail of tail packed
+ * file is unpacked.
+ * New blocks are counted before writing and reserved with one
+ * reserve_blocks() call right after the last stored block of file,
+ * so blocks of one write are contiguous when possible.
+ * Allocates only blocks touched by write. Blocks which become all zeros
+ * (except last one) are not stored. Shared blocks are copied before they
+ * are changed. Clustered file is written by runs of blocks of cluster,
+ * shared cluster is copied as a whole. Writes blocks and inode,
+ * superblock should be written by caller
+ * @param fd opened fd
+ * @param inode
+ * @param superblock
+ * @param position
+ * @param data
+ * @param size
+ * @return count of written bytes if all ok; -1 otherwise
+ */
+ssize_t write_inode_data(int fd,
+                         struct inode* inode,
+                         const struct superblock* superblock,
+                         uint64_t position,
+                         const char* data,
+                         uint64_t size);
+
+/**
+ * @brief Find next data or hole
+ * With LSEEK_END position is offset from end of file.
+ * Only block map of inode is looked through, nothing is read
+ * @param inode
+ * @param superblock
+ * @param position
+ * @param whence LSEEK_DATA, LSEEK_HOLE or LSEEK_END
+ * @return position of data/hole if all ok; -1 otherwise
+ */
+ssize_t seek_inode_data(const struct inode* inode,
+                        const struct superblock* superblock,
+                        uint64_t position,
+                        int whence);
+
+/**
+ * @brief Preallocate blocks of file
+ * Reserves blocks for every hole in first size bytes of file with one
+ * reserve_blocks() call and marks them unwritten. Clustered file reserves
+ * clusters for its holes instead.
+ * Size of file isn't changed. Superblock should be written by caller
+ * @param fd opened fd
+ * @param inode
+ * @param superblock
+ * @param size
+ * @return count of reserved blocks if all ok; -1 otherwise
+ */
+ssize_t allocate_inode_data(int fd,
+                            struct inode* inode,
+                            const struct superblock* superblock,
+                            uint64_t size);
+
+#endif //EXT_FILESYSTEM_CORE_FILE_H_
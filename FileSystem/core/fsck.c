@@ -0,0 +1,503 @@
+/** @author yaishenka
+    @date 19.10.2026 */
+
+#include <stdio.h>
+#include <string.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include "fsck.h"
+#include "inode.h"
+#include "block.h"
+#include "file.h"
+#include "arena.h"
+#include "defines.h"
+#include "methods.h"
+#include "snapshot.h"
+#include "layout.h"
+
+#define FSCK_INODES_CHUNK 64
+
+#define REACHABILITY_UNKNOWN 0
+#define REACHABILITY_VISITING 1
+#define REACHABILITY_REACHABLE 2
+#define REACHABILITY_UNREACHABLE 3
+
+struct fsck_context {
+  int fd;
+  const struct superblock* superblock;
+  atomic_uint next_inode;
+  atomic_uint* block_refs;
+  atomic_uint* inode_links;
+  atomic_uint* parents;
+  atomic_uint bad_records;
+  atomic_uint bad_block_ids;
+  atomic_uint damaged_records;
+  atomic_bool failed;
+};
+
+bool is_bad_record(const struct superblock* superblock, uint16_t inode_id) {
+  return inode_id >= superblock->fs_info->inodes_count
+      || !superblock->reserved_inodes_mask[inode_id];
+}
+
+bool is_bad_block_id(const struct superblock* superblock,
+                     const struct inode* inode,
+                     uint16_t block_id) {
+  int blocks_count = superblock->fs_info->blocks_count;
+  uint16_t cluster_size = get_inode_cluster_size(inode, superblock);
+  if (block_id == blocks_count) {
+    return !inode->inode_info->is_file;
+  }
+
+  return block_id % cluster_size != 0 || block_id > blocks_count - cluster_size;
+}
+
+bool check_inode(struct fsck_context* context, uint16_t inode_id) {
+  const struct superblock* superblock = context->superblock;
+  uint16_t blocks_count = superblock->fs_info->blocks_count;
+
+  struct inode inode;
+  if (read_inode(context->fd, &inode, inode_id, superblock) == -1) {
+    atomic_fetch_add(&context->damaged_records, 1);
+    return true;
+  }
+
+  struct block block;
+  if (!is_inline_inode(&inode)) {
+    uint16_t cluster_size = get_inode_cluster_size(&inode, superblock);
+    for (uint16_t index = 0; index < inode.inode_info->blocks_count;
+         ++index) {
+      uint16_t block_id = inode.block_ids[index];
+      if (is_bad_block_id(superblock, &inode, block_id)) {
+        atomic_fetch_add(&context->bad_block_ids, 1);
+      } else if (block_id != blocks_count) {
+        for (uint16_t i = 0; i < cluster_size; ++i) {
+          atomic_fetch_add(&context->block_refs[block_id + i], 1);
+          if (inode.inode_info->is_file
+              && !superblock->unwritten_blocks_mask[block_id + i]
+              && read_block(context->fd, &block, block_id + i, superblock)
+                  == -1) {
+            atomic_fetch_add(&context->damaged_records, 1);
+          }
+        }
+      }
+    }
+  }
+
+  if (inode.inode_info->is_file || inode.inode_info->blocks_count == 0
+      || inode.block_ids[0] >= blocks_count) {
+    return true;
+  }
+
+  if (read_block(context->fd, &block, inode.block_ids[0], superblock) == -1) {
+    atomic_fetch_add(&context->damaged_records, 1);
+    return true;
+  }
+
+  for (uint8_t record_id = 0; record_id < block.block_info->records_count;
+       ++record_id) {
+    uint16_t child_id = block.block_records[record_id].inode_id;
+    if (is_bad_record(superblock, child_id)) {
+      atomic_fetch_add(&context->bad_records, 1);
+      continue;
+    }
+
+    atomic_fetch_add(&context->inode_links[child_id], 1);
+    unsigned int no_parent = superblock->fs_info->inodes_count;
+    atomic_compare_exchange_strong(&context->parents[child_id],
+                                   &no_parent,
+                                   inode_id);
+  }
+
+  return true;
+}
+
+void* check_inodes_worker(void* argument) {
+  struct fsck_context* context = (struct fsck_context*) argument;
+  uint16_t inodes_count = context->superblock->fs_info->initialized_inodes;
+
+  while (!atomic_load(&context->failed)) {
+    unsigned int begin =
+        atomic_fetch_add(&context->next_inode, FSCK_INODES_CHUNK);
+    if (begin >= inodes_count) {
+      break;
+    }
+
+    unsigned int end = begin + FSCK_INODES_CHUNK;
+    if (end > inodes_count) {
+      end = inodes_count;
+    }
+
+    for (unsigned int inode_id = begin; inode_id < end; ++inode_id) {
+      if (context->superblock->reserved_inodes_mask[inode_id]
+          && !check_inode(context, inode_id)) {
+        atomic_store(&context->failed, true);
+        break;
+      }
+    }
+    reset_arena();
+  }
+
+  release_arena();
+  return NULL;
+}
+
+bool count_snapshot_references(const int fd,
+                               const struct superblock* superblock,
+                               atomic_uint* block_refs) {
+  uint16_t inodes_count = superblock->fs_info->inodes_count;
+  uint16_t blocks_count = superblock->fs_info->blocks_count;
+  size_t inode_size = get_inode_size(superblock);
+
+  for (uint16_t i = 0; i < SNAPSHOTS_COUNT; ++i) {
+    const struct snapshot_info* snapshot = &superblock->snapshots[i];
+    if (snapshot->blocks_count == 0) {
+      continue;
+    }
+
+    for (uint16_t j = 0; j < snapshot->blocks_count; ++j) {
+      atomic_fetch_add(&block_refs[snapshot->first_block_id + j], 1);
+    }
+
+    char* data = read_snapshot(fd, superblock, snapshot);
+    if (data == NULL) {
+      return false;
+    }
+
+    for (uint16_t inode_id = 0; inode_id < inodes_count; ++inode_id) {
+      if (!data[inode_id]) {
+        continue;
+      }
+
+      struct inode inode;
+      memcpy(inode.record,
+             data + inodes_count + inode_id * inode_size,
+             inode_size);
+      init_inode_views(&inode);
+      if (is_inline_inode(&inode)) {
+        continue;
+      }
+
+      uint16_t cluster_size = get_inode_cluster_size(&inode, superblock);
+      for (uint16_t index = 0; index < inode.inode_info->blocks_count;
+           ++index) {
+        if (is_bad_block_id(superblock, &inode, inode.block_ids[index])
+            || inode.block_ids[index] == blocks_count) {
+          continue;
+        }
+
+        for (uint16_t i = 0; i < cluster_size; ++i) {
+          atomic_fetch_add(&block_refs[inode.block_ids[index] + i], 1);
+        }
+      }
+    }
+  }
+
+  return true;
+}
+
+bool is_reachable(const struct superblock* superblock,
+                  const atomic_uint* parents,
+                  uint8_t* reachability,
+                  uint16_t inode_id) {
+  uint16_t inodes_count = superblock->fs_info->inodes_count;
+  uint16_t current = inode_id;
+
+  while (reachability[current] == REACHABILITY_UNKNOWN) {
+    reachability[current] = REACHABILITY_VISITING;
+    unsigned int parent = atomic_load(&parents[current]);
+    if (parent == inodes_count
+        || superblock->orphan_inodes_mask[parent]) {
+      reachability[current] = REACHABILITY_UNREACHABLE;
+      break;
+    }
+    current = parent;
+  }
+
+  uint8_t result = reachability[current] == REACHABILITY_REACHABLE
+      ? REACHABILITY_REACHABLE : REACHABILITY_UNREACHABLE;
+
+  for (current = inode_id; reachability[current] == REACHABILITY_VISITING;
+       current = atomic_load(&parents[current])) {
+    reachability[current] = result;
+  }
+
+  return result == REACHABILITY_REACHABLE;
+}
+
+bool repair_directory(const int fd,
+                      const struct superblock* superblock,
+                      struct inode* inode) {
+  struct block block;
+  if (read_block(fd, &block, inode->block_ids[0], superblock) == -1) {
+    return true;
+  }
+
+  bool changed = false;
+  for (uint8_t record_id = 0; record_id < block.block_info->records_count;) {
+    if (is_bad_record(superblock, block.block_records[record_id].inode_id)) {
+      remove_block_record(&block, record_id);
+      changed = true;
+    } else {
+      ++record_id;
+    }
+  }
+
+  return !changed || write_directory_block(fd, superblock, inode, &block);
+}
+
+bool copy_block(const int fd,
+                const struct superblock* superblock,
+                uint16_t block_id,
+                uint16_t new_block_id,
+                uint16_t inode_id) {
+  if (superblock->unwritten_blocks_mask[block_id]) {
+    superblock->unwritten_blocks_mask[new_block_id] = true;
+    return true;
+  }
+
+  struct block block;
+  if (read_block(fd, &block, block_id, superblock) == -1) {
+    return false;
+  }
+
+  block.block_info->block_id = new_block_id;
+  block.block_info->inode_id = inode_id;
+  return write_block(fd, &block, superblock) != -1;
+}
+
+bool claim_blocks(const struct superblock* superblock,
+                  const atomic_uint* block_refs,
+                  uint16_t* claimed_blocks,
+                  uint16_t first_block_id,
+                  uint16_t count) {
+  for (uint16_t block_id = first_block_id; block_id < first_block_id + count;
+       ++block_id) {
+    uint16_t references = superblock->block_references[block_id] + 1;
+    if (atomic_load(&block_refs[block_id]) > references
+        && claimed_blocks[block_id] >= references) {
+      return false;
+    }
+  }
+
+  for (uint16_t block_id = first_block_id; block_id < first_block_id + count;
+       ++block_id) {
+    uint16_t references = superblock->block_references[block_id] + 1;
+    if (atomic_load(&block_refs[block_id]) > references) {
+      claimed_blocks[block_id] += 1;
+    }
+  }
+
+  return true;
+}
+
+bool repair_inode(const int fd,
+                  const struct superblock* superblock,
+                  uint16_t inode_id,
+                  const atomic_uint* block_refs,
+                  uint16_t* claimed_blocks) {
+  uint16_t blocks_count = superblock->fs_info->blocks_count;
+
+  struct inode inode;
+  if (read_inode(fd, &inode, inode_id, superblock) == -1) {
+    return true;
+  }
+
+  if (!inode.inode_info->is_file && inode.inode_info->blocks_count != 0
+      && inode.block_ids[0] < blocks_count
+      && !repair_directory(fd, superblock, &inode)) {
+    return false;
+  }
+
+  if (is_inline_inode(&inode)) {
+    return true;
+  }
+
+  uint16_t cluster_size = get_inode_cluster_size(&inode, superblock);
+  bool changed = false;
+  for (uint16_t index = 0; index < inode.inode_info->blocks_count; ++index) {
+    uint16_t block_id = inode.block_ids[index];
+    if (block_id != blocks_count
+        && is_bad_block_id(superblock, &inode, block_id)) {
+      inode.block_ids[index] = blocks_count;
+      changed = true;
+      continue;
+    }
+
+    if (block_id == blocks_count
+        || claim_blocks(superblock,
+                        block_refs,
+                        claimed_blocks,
+                        block_id,
+                        cluster_size)) {
+      continue;
+    }
+
+    uint16_t new_block_id = is_clustered_inode(&inode)
+        ? reserve_cluster(superblock, 0) : reserve_block(superblock);
+    if (new_block_id == blocks_count) {
+      fprintf(stderr, "Can't create more blocks in FS. Skip!\n");
+      continue;
+    }
+
+    for (uint16_t i = 0; i < cluster_size; ++i) {
+      if (!copy_block(fd,
+                      superblock,
+                      block_id + i,
+                      new_block_id + i,
+                      inode_id)) {
+        return false;
+      }
+    }
+    inode.block_ids[index] = new_block_id;
+    changed = true;
+  }
+
+  while (inode.inode_info->blocks_count > 0
+      && inode.block_ids[inode.inode_info->blocks_count - 1] == blocks_count) {
+    inode.inode_info->blocks_count -= 1;
+    changed = true;
+  }
+
+  return !changed || write_inode(fd, &inode, superblock) != -1;
+}
+
+ssize_t check_fs(const int fd,
+                 const struct superblock* superblock,
+                 bool repair,
+                 uint16_t threads_count,
+                 struct fsck_report* report) {
+  uint16_t inodes_count = superblock->fs_info->inodes_count;
+  uint16_t blocks_count = superblock->fs_info->blocks_count;
+  memset(report, 0, sizeof(struct fsck_report));
+  if (superblock->snapshot_inodes != NULL) {
+    fprintf(stderr, "Can't check mounted snapshot. Abort!\n");
+    return -1;
+  }
+
+  struct fsck_context context;
+  context.fd = fd;
+  context.superblock = superblock;
+  atomic_init(&context.next_inode, 0);
+  atomic_init(&context.bad_records, 0);
+  atomic_init(&context.bad_block_ids, 0);
+  atomic_init(&context.damaged_records, 0);
+  atomic_init(&context.failed, false);
+  context.block_refs =
+      (atomic_uint*) arena_calloc(blocks_count, sizeof(atomic_uint));
+  context.inode_links =
+      (atomic_uint*) arena_calloc(inodes_count, sizeof(atomic_uint));
+  context.parents =
+      (atomic_uint*) arena_calloc(inodes_count, sizeof(atomic_uint));
+  for (uint16_t block_id = 0; block_id < blocks_count; ++block_id) {
+    atomic_init(&context.block_refs[block_id], 0);
+  }
+  for (uint16_t inode_id = 0; inode_id < inodes_count; ++inode_id) {
+    atomic_init(&context.inode_links[inode_id], 0);
+    atomic_init(&context.parents[inode_id], inodes_count);
+  }
+
+  if (threads_count == 0) {
+    threads_count = 1;
+  }
+  pthread_t* threads =
+      (pthread_t*) arena_calloc(threads_count, sizeof(pthread_t));
+  uint16_t started = 0;
+  for (; started < threads_count; ++started) {
+    if (pthread_create(&threads[started],
+                       NULL,
+                       check_inodes_worker,
+                       &context) != 0) {
+      break;
+    }
+  }
+
+  if (started == 0) {
+    fprintf(stderr, "Can't start fsck workers. Abort!\n");
+    return -1;
+  }
+  for (uint16_t i = 0; i < started; ++i) {
+    pthread_join(threads[i], NULL);
+  }
+
+  if (atomic_load(&context.failed)) {
+    fprintf(stderr, "Can't read inodes. Abort!\n");
+    return -1;
+  }
+
+  if (!count_snapshot_references(fd, superblock, context.block_refs)) {
+    fprintf(stderr, "Can't read snapshots. Abort!\n");
+    return -1;
+  }
+
+  report->bad_records = atomic_load(&context.bad_records);
+  report->bad_block_ids = atomic_load(&context.bad_block_ids);
+  report->damaged_records = atomic_load(&context.damaged_records);
+
+  uint8_t* reachability = (uint8_t*) arena_calloc(inodes_count, sizeof(uint8_t));
+  reachability[ROOT_INODE_ID] = REACHABILITY_REACHABLE;
+  for (uint16_t inode_id = 0; inode_id < inodes_count; ++inode_id) {
+    if (!superblock->reserved_inodes_mask[inode_id]) {
+      continue;
+    }
+
+    ++report->checked_inodes;
+    if (atomic_load(&context.inode_links[inode_id]) > 1) {
+      ++report->multiply_linked_inodes;
+    }
+
+    if (!superblock->orphan_inodes_mask[inode_id]
+        && !is_reachable(superblock, context.parents, reachability, inode_id)) {
+      ++report->unreachable_inodes;
+      if (repair) {
+        superblock->orphan_inodes_mask[inode_id] = true;
+      }
+    }
+  }
+
+  for (uint16_t block_id = 0; block_id < blocks_count; ++block_id) {
+    unsigned int refs = atomic_load(&context.block_refs[block_id]);
+    unsigned int references = superblock->block_references[block_id] + 1;
+    if (refs > references) {
+      ++report->doubly_allocated_blocks;
+    } else if (refs != 0 && refs < references) {
+      ++report->bad_references;
+      if (repair) {
+        superblock->block_references[block_id] = refs - 1;
+      }
+    }
+
+    if (refs == 0 && superblock->reserved_blocks_mask[block_id]) {
+      ++report->leaked_blocks;
+      if (repair && report->damaged_records == 0) {
+        free_block(superblock, block_id);
+      }
+    } else if (refs != 0 && !superblock->reserved_blocks_mask[block_id]) {
+      ++report->unreserved_blocks;
+      if (repair) {
+        superblock->reserved_blocks_mask[block_id] = true;
+      }
+    }
+  }
+
+  uint16_t* claimed_blocks =
+      (uint16_t*) arena_calloc(blocks_count, sizeof(uint16_t));
+  if (repair) {
+    for (uint16_t inode_id = 0; inode_id < inodes_count; ++inode_id) {
+      if (superblock->reserved_inodes_mask[inode_id]
+          && !repair_inode(fd,
+                           superblock,
+                           inode_id,
+                           context.block_refs,
+                           claimed_blocks)) {
+        fprintf(stderr, "Can't repair inode. Abort!\n");
+        return -1;
+      }
+    }
+  }
+
+  return report->unreachable_inodes + report->multiply_linked_inodes
+      + report->bad_records + report->bad_block_ids + report->leaked_blocks
+      + report->unreserved_blocks + report->doubly_allocated_blocks
+      + report->bad_references + report->damaged_records;
+}
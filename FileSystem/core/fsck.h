@@ -0,0 +1,62 @@
+/**
+ * @file fsck.h
+ * @author yaishenka
+ * @date 19.10.2026
+ * @brief Contains consistency checker of FS
+ *
+ * Inode table is split between worker threads. Every worker reads its
+ * inodes and directory blocks and counts references to blocks and inodes
+ * with atomics. Masks of superblock are cross-checked with these counts
+ * after workers are joined.
+ */
+#ifndef EXT_FILESYSTEM_CORE_FSCK_H_
+#define EXT_FILESYSTEM_CORE_FSCK_H_
+#include <stdint.h>
+#include <stdbool.h>
+#include <unistd.h>
+#include "superblock.h"
+
+/**
+ * @brief Problems found by check_fs
+ */
+struct fsck_report {
+  uint32_t checked_inodes;
+  uint32_t unreachable_inodes;
+  uint32_t multiply_linked_inodes;
+  uint32_t bad_records;
+  uint32_t bad_block_ids;
+  uint32_t leaked_blocks;
+  uint32_t unreserved_blocks;
+  uint32_t doubly_allocated_blocks;
+  uint32_t bad_references;
+  uint32_t damaged_records;
+};
+
+/**
+ * @brief Check consistency of FS
+ * With repair:
+ * unreachable inodes become orphans (see reclaim_orphans()),
+ * records with bad inode ids are removed,
+ * bad block ids become holes,
+ * leaked blocks are released and referenced blocks are reserved,
+ * every extra owner of doubly allocated block gets its own copy,
+ * references of shared blocks are set to count of their owners
+ * (inodes and snapshots).
+ * Damaged records (inodes and blocks with bad checksum) are only reported,
+ * and leaked blocks are kept while there are any: ids of blocks of damaged
+ * inode are unknown.
+ * Superblock should be written by caller
+ * @param fd opened fd
+ * @param superblock
+ * @param repair
+ * @param threads_count count of worker threads
+ * @param report
+ * @return count of found problems if all ok; -1 if FS can't be read
+ */
+ssize_t check_fs(int fd,
+                 const struct superblock* superblock,
+                 bool repair,
+                 uint16_t threads_count,
+                 struct fsck_report* report);
+
+#endif //EXT_FILESYSTEM_CORE_FSCK_H_
@@ -5,109 +5,170 @@
 #include <stdio.h>
 #include <errno.h>
 #include <string.h>
+#include <time.h>
 #include "inode.h"
 #include "../utils.h"
-#include "descriptors_table.h"
+#include "layout.h"
 
-size_t sizeof_inode(const struct superblock* superblock) {
-  return sizeof(struct inode_info)
-      + sizeof(uint16_t) * superblock->fs_info->blocks_count_in_inode;
-}
+_Static_assert(sizeof(struct inode_info) % sizeof(uint16_t) == 0,
+               "block_ids in inode record must be aligned");
 
-size_t calculate_offset(const struct superblock* superblock,
-                        uint16_t inode_id) {
-  return sizeof_superblock(superblock) + sizeof_descriptors_table(superblock)
-      + inode_id * sizeof_inode(superblock);
-}
-
-void init_inode_arrays(struct inode* inode,
-                       const struct superblock* superblock) {
-  inode->block_ids =
-      (uint16_t*) calloc(superblock->fs_info->blocks_count_in_inode,
-                         sizeof(uint16_t));
+size_t sizeof_inode(const struct superblock* superblock) {
+  return get_inode_size(superblock);
 }
 
-void init_inode_info(struct inode* inode) {
-  inode->inode_info = (struct inode_info*) calloc(1, sizeof(struct inode_info));
+void init_inode_views(struct inode* inode) {
+  inode->inode_info = (struct inode_info*) inode->record;
+  inode->block_ids = (uint16_t*) (inode->record + sizeof(struct inode_info));
 }
 
-void init_inode(struct inode* inode,
-                uint16_t id,
-                bool is_file,
-                const struct superblock* superblock) {
-  init_inode_info(inode);
+void init_inode(struct inode* inode, uint16_t id, bool is_file) {
+  memset(inode->record, 0, sizeof(inode->record));
+  init_inode_views(inode);
   inode->inode_info->id = id;
   inode->inode_info->is_file = is_file;
   inode->inode_info->blocks_count = 0;
-  init_inode_arrays(inode, superblock);
-}
-void destroy_inode(struct inode* inode) {
-  free(inode->inode_info);
-  free(inode->block_ids);
+  inode->inode_info->modified_time = time(NULL);
 }
 
 ssize_t read_inode(int fd,
                    struct inode* inode,
                    uint16_t inode_id,
                    const struct superblock* superblock) {
-  init_inode_info(inode);
-  lseek(fd,
-        calculate_offset(superblock, inode_id),
-        SEEK_SET);
+  init_inode_views(inode);
+
+  if (superblock->snapshot_inodes != NULL) {
+    memcpy(inode->record,
+           superblock->snapshot_inodes
+               + (size_t) inode_id * get_inode_size(superblock),
+           get_inode_size(superblock));
+    if (!is_record_checksum_valid(inode->record, get_inode_size(superblock))) {
+      fprintf(stderr, "Inode checksum mismatch!\n");
+      return -1;
+    }
+    return get_inode_size(superblock);
+  }
 
-  ssize_t total_read =
-      read_while(fd, (char*) inode->inode_info, sizeof(struct inode_info));
+  if (inode_id >= superblock->fs_info->initialized_inodes) {
+    memset(inode->record, 0, sizeof(inode->record));
+    inode->inode_info->id = inode_id;
+    return get_inode_size(superblock);
+  }
+
+  ssize_t total_read = pread_while(fd,
+                                   inode->record,
+                                   get_inode_size(superblock),
+                                   get_inode_offset(superblock, inode_id));
 
   if (total_read == -1) {
     fprintf(stderr, "%s", strerror(errno));
-    free(inode->inode_info);
     return -1;
   }
 
-  init_inode_arrays(inode, superblock);
+  if (superblock->backing != NULL
+      && is_zero_memory(inode->record, get_inode_size(superblock))) {
+    return read_inode(superblock->backing_fd,
+                      inode,
+                      inode_id,
+                      superblock->backing);
+  }
 
-  ssize_t readed = read_while(fd,
-                              (char*) inode->block_ids,
-                              sizeof(uint16_t)
-                                  * superblock->fs_info->blocks_count_in_inode);
+  if (!is_record_checksum_valid(inode->record, get_inode_size(superblock))) {
+    fprintf(stderr, "Inode checksum mismatch!\n");
+    return -1;
+  }
 
-  if (readed == -1) {
+  return total_read;
+}
+
+ssize_t read_inodes_table(int fd,
+                          const struct superblock* superblock,
+                          char* inodes) {
+  size_t inode_size = get_inode_size(superblock);
+  ssize_t total_read = pread_while(fd,
+                                   inodes,
+                                   sizeof_inodes_block(superblock),
+                                   get_inode_offset(superblock, 0));
+  if (total_read == -1) {
     fprintf(stderr, "%s", strerror(errno));
-    destroy_inode(inode);
     return -1;
   }
 
-  return total_read + readed;
+  if (superblock->backing == NULL) {
+    return total_read;
+  }
+
+  for (uint16_t id = 0; id < superblock->fs_info->inodes_count; ++id) {
+    char* record = inodes + id * inode_size;
+    if (!is_zero_memory(record, inode_size)) {
+      continue;
+    }
+
+    struct inode inode;
+    if (read_inode(superblock->backing_fd,
+                   &inode,
+                   id,
+                   superblock->backing) == -1) {
+      return -1;
+    }
+    memcpy(record, inode.record, inode_size);
+  }
+
+  return total_read;
 }
 
 ssize_t write_inode(int fd,
                     struct inode* inode,
                     const struct superblock* superblock) {
-  lseek(fd,
-        calculate_offset(superblock, inode->inode_info->id),
-        SEEK_SET);
-
-  ssize_t total_written = write_while(fd,
-                                      (const char*) inode->inode_info,
-                                      sizeof(struct inode_info));
-  if (total_written == -1) {
-    fprintf(stderr, "%s", strerror(errno));
+  if (superblock->snapshot_inodes != NULL) {
+    fprintf(stderr, "Snapshot is read-only!\n");
     return -1;
   }
 
-  ssize_t written = write_while(fd,
-                                (const char*) inode->block_ids,
-                                sizeof(uint16_t)
-                                    * superblock->fs_info->blocks_count_in_inode);
+  set_record_checksum(inode->record, get_inode_size(superblock));
+  ssize_t total_written =
+      pwrite_while(fd,
+                   inode->record,
+                   get_inode_size(superblock),
+                   get_inode_offset(superblock, inode->inode_info->id));
 
-  if (written == -1) {
+  if (total_written == -1) {
     fprintf(stderr, "%s", strerror(errno));
     return -1;
   }
 
-  return total_written + written;
+  return total_written;
+}
+
+bool is_inline_inode(const struct inode* inode) {
+  return (inode->inode_info->flags & INODE_FLAG_INLINE) != 0;
+}
+
+bool is_compressed_inode(const struct inode* inode) {
+  return (inode->inode_info->flags & INODE_FLAG_COMPRESSED) != 0;
+}
+
+bool is_clustered_inode(const struct inode* inode) {
+  return (inode->inode_info->flags & INODE_FLAG_CLUSTERS) != 0;
+}
+
+bool is_tail_inode(const struct inode* inode) {
+  return (inode->inode_info->flags & INODE_FLAG_TAIL) != 0;
+}
+
+uint16_t get_inode_cluster_size(const struct inode* inode,
+                                const struct superblock* superblock) {
+  return is_clustered_inode(inode) ? get_cluster_size(superblock) : 1;
+}
+
+char* get_inline_data(const struct inode* inode) {
+  return (char*) inode->block_ids;
+}
+
+uint32_t get_inline_capacity(const struct superblock* superblock) {
+  return sizeof(uint16_t) * superblock->fs_info->blocks_count_in_inode;
 }
 
-uint16_t sizeof_inodes_block(const struct superblock* superblock) {
-  return superblock->fs_info->inodes_count * sizeof_inode(superblock);
+size_t sizeof_inodes_block(const struct superblock* superblock) {
+  return superblock->fs_info->inodes_count * get_inode_size(superblock);
 }
\ No newline at end of file
@@ -10,26 +10,75 @@
 #include <stdint.h>
 #include <stdbool.h>
 #include "superblock.h"
+#include "defines.h"
 
 /**
  * @brief Contains information about inode
  *
- * This struct contains info that can be simply written to memory
+ * This struct contains info that can be simply written to memory.
+ * Its size is even, so block_ids which follow it in record are aligned.
+ * size is size of file data in bytes, so it is known without reading blocks.
+ * modified_time is time of last change of file data (seconds since Epoch).
+ * tail_offset is offset of last block of file in its tail block
+ * (see INODE_FLAG_TAIL).
+ * parent_id is id of parent of directory (root is parent of itself),
+ * ".." is resolved with it
  */
 struct __attribute__((__packed__)) inode_info {
+  uint32_t checksum;
   uint16_t id;
   uint16_t blocks_count;
   bool is_file;
+  uint8_t flags;
+  uint64_t size;
+  uint64_t modified_time;
+  uint16_t tail_offset;
+  uint16_t parent_id;
 };
 
+/**
+ * @brief Data of file is stored inline in place of block_ids
+ * blocks_count is size of inline data in this case
+ */
+#define INODE_FLAG_INLINE 1
+
+/**
+ * @brief Data of file is one LZ compressed extent over all its blocks
+ * Extent starts with uint32_t size of decompressed data, see core/lz.h
+ */
+#define INODE_FLAG_COMPRESSED 2
+
+/**
+ * @brief Every block_ids entry is cluster (see FS_FLAG_BIGALLOC)
+ * Entry is id of first block of cluster, block with index i of file is
+ * block_ids[i / cluster size] + i % cluster size
+ */
+#define INODE_FLAG_CLUSTERS 4
+
+/**
+ * @brief Last block of file is tail packed with tails of other files
+ * Tail is stored in block block_ids[blocks_count - 1] at tail_offset,
+ * its length is the rest of file size
+ */
+#define INODE_FLAG_TAIL 8
+
+/**
+ * @brief Max size of on-disk inode: inode_info and block_ids
+ */
+#define INODE_RECORD_SIZE \
+  (sizeof(struct inode_info) + sizeof(uint16_t) * BLOCKS_COUNT_IN_INODE)
+
 /**
  * @brief Main inode struct
  *
- * This struct represent inode
+ * This struct represent inode. record is on-disk inode,
+ * inode_info and block_ids are views into it, so inode is read with one copy.
+ * @warning Don't copy inode by value: views will point to the old record
  */
-struct __attribute__((__packed__)) inode {
+struct inode {
   struct inode_info* inode_info;
   uint16_t* block_ids;
+  _Alignas(uint64_t) char record[INODE_RECORD_SIZE];
 };
 
 /**
@@ -39,30 +88,31 @@ struct __attribute__((__packed__)) inode {
  */
 size_t sizeof_inode(const struct superblock* superblock);
 
+/**
+ * @brief Point inode_info and block_ids to record of inode
+ * @param inode
+ */
+void init_inode_views(struct inode* inode);
+
 /**
  * @brief Constructor of inode
  * @param inode empty instance of inode
  * @param id id of inode
  * @param is_file
  */
-void init_inode(struct inode* inode,
-                uint16_t id,
-                bool is_file,
-                const struct superblock* superblock);
-
-/**
- * @brief Destructor of inode
- * @param inode
- */
-void destroy_inode(struct inode* inode);
+void init_inode(struct inode* inode, uint16_t id, bool is_file);
 
 /**
  * @brief Read inode from memory
+ * Inode is read with one pread straight into inode->record.
+ * Never initialized inode (see fs_info->initialized_inodes) is zeroed
+ * without reading. Inode of mounted snapshot is copied from snapshot.
+ * Inode which was never written to overlay is read from backing image
  * @param fd opened fd
  * @param inode empty instance of inode
  * @param inode_id id of inode to read
  * @param superblock the superblock with metadata of FS
- * @return sizeof(inode) if reading is ok; -1 otherwise and destruct inode object
+ * @return sizeof(inode) if reading is ok; -1 otherwise
  * @warning printf strerror(errno) to stderr
  */
 ssize_t read_inode(int fd,
@@ -70,6 +120,19 @@ ssize_t read_inode(int fd,
                    uint16_t inode_id,
                    const struct superblock* superblock);
 
+/**
+ * @brief Read records of all inodes
+ * Table is read with one pread. Records which were never written to overlay
+ * are read from backing image
+ * @param fd opened fd
+ * @param superblock the superblock with metadata of FS
+ * @param inodes buffer of sizeof_inodes_block() bytes
+ * @return size of table if reading is ok; -1 otherwise
+ */
+ssize_t read_inodes_table(int fd,
+                          const struct superblock* superblock,
+                          char* inodes);
+
 /**
  * @brief Write inode from memory
  * @param fd opened fd
@@ -82,11 +145,62 @@ ssize_t write_inode(int fd,
                     struct inode* inode,
                     const struct superblock* superblock);
 
+/**
+ * @brief Check if data of inode is stored inline
+ * @param inode
+ * @return
+ */
+bool is_inline_inode(const struct inode* inode);
+
+/**
+ * @brief Check if data of inode is compressed
+ * @param inode
+ * @return
+ */
+bool is_compressed_inode(const struct inode* inode);
+
+/**
+ * @brief Check if data of inode is allocated by clusters
+ * @param inode
+ * @return
+ */
+bool is_clustered_inode(const struct inode* inode);
+
+/**
+ * @brief Check if last block of inode is packed in tail block
+ * @param inode
+ * @return
+ */
+bool is_tail_inode(const struct inode* inode);
+
+/**
+ * @brief Count blocks addressed by one block_ids entry of inode
+ * @param inode
+ * @param superblock
+ * @return get_cluster_size() for clustered inode; 1 otherwise
+ */
+uint16_t get_inode_cluster_size(const struct inode* inode,
+                                const struct superblock* superblock);
+
+/**
+ * @brief Get inline data of inode
+ * @param inode
+ * @return pointer to data stored in place of block_ids
+ */
+char* get_inline_data(const struct inode* inode);
+
+/**
+ * @brief Calculate max size of inline data
+ * @param superblock
+ * @return
+ */
+uint32_t get_inline_capacity(const struct superblock* superblock);
+
 /**
  * @brief Calculate size of block of all inodes
  * @param superblock
  * @return
  */
-uint16_t sizeof_inodes_block(const struct superblock* superblock);
+size_t sizeof_inodes_block(const struct superblock* superblock);
 
 #endif //EXT_FILESYSTEM_INODE_H_
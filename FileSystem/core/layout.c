@@ -0,0 +1,56 @@
+/** @author yaishenka
+    @date 19.10.2026 */
+#include "layout.h"
+#include "descriptors_table.h"
+
+size_t align_region(const struct fs_info* fs_info, size_t offset) {
+  if (!(fs_info->flags & FS_FLAG_ALIGNED)) {
+    return offset;
+  }
+
+  return (offset + IMAGE_ALIGNMENT - 1) / IMAGE_ALIGNMENT * IMAGE_ALIGNMENT;
+}
+
+bool is_default_geometry(const struct fs_info* fs_info) {
+  return (fs_info->flags & (FS_FLAG_ALIGNED | FS_FLAG_DEDUP | FS_FLAG_OVERLAY)) == 0
+      && fs_info->inodes_count == INODES_COUNT
+      && fs_info->blocks_count == BLOCKS_COUNT
+      && fs_info->block_size == BLOCK_SIZE
+      && fs_info->blocks_count_in_inode == BLOCKS_COUNT_IN_INODE
+      && fs_info->max_path_len == MAX_PATH_LEN
+      && fs_info->descriptors_count == DESCRIPTORS_COUNT;
+}
+
+void init_layout(struct superblock* superblock) {
+  const struct fs_info* fs_info = superblock->fs_info;
+  struct layout* layout = &superblock->layout;
+
+  layout->descriptors_table_offset =
+      align_region(fs_info, sizeof_superblock(superblock));
+  layout->inodes_offset =
+      align_region(fs_info,
+                   layout->descriptors_table_offset
+                       + sizeof_descriptors_table(superblock));
+  layout->inode_size = sizeof(struct inode_info)
+      + sizeof(uint16_t) * fs_info->blocks_count_in_inode;
+  layout->block_table_offset =
+      align_region(fs_info,
+                   layout->inodes_offset
+                       + fs_info->inodes_count * layout->inode_size);
+  layout->blocks_offset =
+      align_region(fs_info,
+                   layout->block_table_offset
+                       + fs_info->blocks_count * sizeof(struct block_info));
+  layout->max_data_in_block = fs_info->block_size;
+  layout->block_shift = 0;
+  while ((1u << layout->block_shift) < fs_info->block_size) {
+    ++layout->block_shift;
+  }
+
+  size_t max_records_count =
+      layout->max_data_in_block / DIRECTORY_RECORD_HEADER_SIZE;
+  layout->max_records_count =
+      max_records_count > UINT8_MAX ? UINT8_MAX : max_records_count;
+
+  layout->is_default = is_default_geometry(fs_info);
+}
@@ -0,0 +1,163 @@
+/**
+ * @file layout.h
+ * @author yaishenka
+ * @date 19.10.2026
+ * @brief Contains offsets of FS regions
+ *
+ * Layout of image is superblock, descriptors table, inodes, block table, blocks.
+ * Block table holds block_info of every block, so block carries exactly
+ * block_size bytes of data and block_size is power of two: positions in file
+ * are mapped to blocks with shifts and masks.
+ * Layout of default geometry (core/defines.h) is folded into constants,
+ * superblock->layout.is_default selects this fast path when image is mounted.
+ * Other geometries use layout computed once from fs_info.
+ * Image with FS_FLAG_ALIGNED has every region aligned to IMAGE_ALIGNMENT
+ * and block_size multiple of it, so blocks can be read with O_DIRECT
+ */
+#ifndef EXT_FILESYSTEM_CORE_LAYOUT_H_
+#define EXT_FILESYSTEM_CORE_LAYOUT_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "defines.h"
+#include "superblock.h"
+#include "inode.h"
+#include "block.h"
+
+#define DEFAULT_SUPERBLOCK_SIZE \
+  (sizeof(struct fs_info) \
+      + sizeof(bool) * (2 * INODES_COUNT + 2 * BLOCKS_COUNT) \
+      + sizeof(uint8_t) * BLOCKS_COUNT \
+      + sizeof(struct snapshot_info) * SNAPSHOTS_COUNT)
+#define DEFAULT_DESCRIPTORS_TABLE_SIZE \
+  (DESCRIPTORS_COUNT * (sizeof(bool) + sizeof(uint16_t) + sizeof(uint64_t)))
+#define DEFAULT_INODE_SIZE INODE_RECORD_SIZE
+#define DEFAULT_INODES_OFFSET \
+  (DEFAULT_SUPERBLOCK_SIZE + DEFAULT_DESCRIPTORS_TABLE_SIZE)
+#define DEFAULT_BLOCK_TABLE_OFFSET \
+  (DEFAULT_INODES_OFFSET + INODES_COUNT * DEFAULT_INODE_SIZE)
+#define DEFAULT_BLOCKS_OFFSET \
+  (DEFAULT_BLOCK_TABLE_OFFSET + BLOCKS_COUNT * sizeof(struct block_info))
+#define DEFAULT_MAX_DATA_IN_BLOCK BLOCK_SIZE
+#define DEFAULT_MAX_RECORDS_COUNT \
+  (DEFAULT_MAX_DATA_IN_BLOCK / DIRECTORY_RECORD_HEADER_SIZE)
+
+_Static_assert((BLOCK_SIZE & (BLOCK_SIZE - 1)) == 0
+                   && (ALIGNED_BLOCK_SIZE & (ALIGNED_BLOCK_SIZE - 1)) == 0,
+               "Block size must be power of two");
+_Static_assert(DIRECTORY_RECORD_HEADER_SIZE + MAX_PATH_LEN
+                   <= DEFAULT_MAX_DATA_IN_BLOCK,
+               "Directory block must have place for record with longest name");
+_Static_assert(DEFAULT_MAX_RECORDS_COUNT <= UINT8_MAX,
+               "records_count is uint8_t");
+_Static_assert(INODES_COUNT <= UINT16_MAX && BLOCKS_COUNT <= UINT16_MAX,
+               "Ids are uint16_t");
+
+/**
+ * @brief Compute layout of superblock
+ * Must be called after fs_info is set
+ * @param superblock
+ */
+void init_layout(struct superblock* superblock);
+
+/**
+ * @param superblock
+ * @return offset of descriptors table
+ */
+static inline size_t get_descriptors_table_offset(
+    const struct superblock* superblock) {
+  if (superblock->layout.is_default) {
+    return DEFAULT_SUPERBLOCK_SIZE;
+  }
+
+  return superblock->layout.descriptors_table_offset;
+}
+
+/**
+ * @param superblock
+ * @return size of on-disk inode
+ */
+static inline size_t get_inode_size(const struct superblock* superblock) {
+  if (superblock->layout.is_default) {
+    return DEFAULT_INODE_SIZE;
+  }
+
+  return superblock->layout.inode_size;
+}
+
+/**
+ * @param superblock
+ * @param inode_id
+ * @return offset of inode in image
+ */
+static inline size_t get_inode_offset(const struct superblock* superblock,
+                                      uint16_t inode_id) {
+  if (superblock->layout.is_default) {
+    return DEFAULT_INODES_OFFSET + (size_t) inode_id * DEFAULT_INODE_SIZE;
+  }
+
+  return superblock->layout.inodes_offset
+      + (size_t) inode_id * superblock->layout.inode_size;
+}
+
+/**
+ * @param superblock
+ * @param block_id
+ * @return offset of block_info of block in image
+ */
+static inline size_t get_block_info_offset(const struct superblock* superblock,
+                                           uint16_t block_id) {
+  if (superblock->layout.is_default) {
+    return DEFAULT_BLOCK_TABLE_OFFSET
+        + (size_t) block_id * sizeof(struct block_info);
+  }
+
+  return superblock->layout.block_table_offset
+      + (size_t) block_id * sizeof(struct block_info);
+}
+
+/**
+ * @param superblock
+ * @param block_id
+ * @return offset of block in image
+ */
+static inline size_t get_block_offset(const struct superblock* superblock,
+                                      uint16_t block_id) {
+  if (superblock->layout.is_default) {
+    return DEFAULT_BLOCKS_OFFSET + (size_t) block_id * BLOCK_SIZE;
+  }
+
+  return superblock->layout.blocks_offset
+      + (size_t) block_id * superblock->fs_info->block_size;
+}
+
+/**
+ * @param superblock
+ * @param position position in file
+ * @return index of block in inode which contains position
+ */
+static inline uint64_t get_block_index(const struct superblock* superblock,
+                                       uint64_t position) {
+  if (superblock->layout.is_default) {
+    return position / DEFAULT_MAX_DATA_IN_BLOCK;
+  }
+
+  return position >> superblock->layout.block_shift;
+}
+
+/**
+ * @param superblock
+ * @param position position in file
+ * @return position in data of block which contains position
+ */
+static inline uint32_t get_position_in_block(
+    const struct superblock* superblock,
+    uint64_t position) {
+  if (superblock->layout.is_default) {
+    return position % DEFAULT_MAX_DATA_IN_BLOCK;
+  }
+
+  return position & (superblock->layout.max_data_in_block - 1);
+}
+
+#endif //EXT_FILESYSTEM_CORE_LAYOUT_H_
@@ -0,0 +1,180 @@
+/** @author yaishenka
+    @date 19.10.2026 */
+
+#include <string.h>
+#include "lz.h"
+
+uint32_t lz_hash(const char* position) {
+  uint32_t sequence;
+  memcpy(&sequence, position, sizeof(uint32_t));
+  return (sequence * 2654435761u) >> (32 - LZ_HASH_BITS);
+}
+
+void lz_write_length(char* dest, size_t* written, size_t length) {
+  for (; length >= UINT8_MAX; length -= UINT8_MAX) {
+    dest[(*written)++] = (char) UINT8_MAX;
+  }
+  dest[(*written)++] = (char) length;
+}
+
+bool lz_read_length(const char* source,
+                    size_t size,
+                    size_t* read,
+                    size_t* length) {
+  uint8_t byte;
+  do {
+    if (*read == size) {
+      return false;
+    }
+    byte = (uint8_t) source[(*read)++];
+    *length += byte;
+  } while (byte == UINT8_MAX);
+
+  return true;
+}
+
+bool lz_write_sequence(char* dest,
+                       size_t capacity,
+                       size_t* written,
+                       const char* literals,
+                       size_t literals_length,
+                       size_t offset,
+                       size_t match_length) {
+  size_t needed = 1 + literals_length / UINT8_MAX + 1 + literals_length
+      + sizeof(uint16_t) + match_length / UINT8_MAX + 1;
+  if (*written + needed > capacity) {
+    return false;
+  }
+
+  size_t match_code = match_length == 0 ? 0 : match_length - LZ_MIN_MATCH + 1;
+  uint8_t token = (literals_length < 15 ? literals_length : 15) << 4
+      | (match_code < 15 ? match_code : 15);
+  dest[(*written)++] = (char) token;
+
+  if (literals_length >= 15) {
+    lz_write_length(dest, written, literals_length - 15);
+  }
+  memcpy(dest + *written, literals, literals_length);
+  *written += literals_length;
+
+  if (match_length == 0) {
+    return true;
+  }
+
+  dest[(*written)++] = (char) (offset & 0xFF);
+  dest[(*written)++] = (char) (offset >> 8);
+  if (match_code >= 15) {
+    lz_write_length(dest, written, match_code - 15);
+  }
+
+  return true;
+}
+
+size_t lz_compress(const char* source,
+                   const size_t size,
+                   char* dest,
+                   const size_t capacity) {
+  uint32_t table[1 << LZ_HASH_BITS];
+  memset(table, 0, sizeof(table));
+
+  size_t anchor = 0;
+  size_t position = 0;
+  size_t written = 0;
+
+  while (position + LZ_MIN_MATCH <= size) {
+    uint32_t hash = lz_hash(source + position);
+    size_t candidate = table[hash];
+    table[hash] = position + 1;
+
+    if (candidate == 0 || position - (candidate - 1) > LZ_MAX_OFFSET
+        || memcmp(source + candidate - 1, source + position, LZ_MIN_MATCH)
+            != 0) {
+      ++position;
+      continue;
+    }
+
+    --candidate;
+    size_t match_length = LZ_MIN_MATCH;
+    while (position + match_length < size
+        && source[candidate + match_length] == source[position + match_length]) {
+      ++match_length;
+    }
+
+    if (!lz_write_sequence(dest,
+                           capacity,
+                           &written,
+                           source + anchor,
+                           position - anchor,
+                           position - candidate,
+                           match_length)) {
+      return 0;
+    }
+
+    position += match_length;
+    anchor = position;
+  }
+
+  if (!lz_write_sequence(dest,
+                         capacity,
+                         &written,
+                         source + anchor,
+                         size - anchor,
+                         0,
+                         0)) {
+    return 0;
+  }
+
+  return written;
+}
+
+ssize_t lz_decompress(const char* source,
+                      const size_t size,
+                      char* dest,
+                      const size_t capacity) {
+  size_t read = 0;
+  size_t written = 0;
+
+  while (read < size) {
+    uint8_t token = (uint8_t) source[read++];
+
+    size_t literals_length = token >> 4;
+    if (literals_length == 15
+        && !lz_read_length(source, size, &read, &literals_length)) {
+      return -1;
+    }
+    if (literals_length > size - read || literals_length > capacity - written) {
+      return -1;
+    }
+    memcpy(dest + written, source + read, literals_length);
+    read += literals_length;
+    written += literals_length;
+
+    size_t match_length = token & 0xF;
+    if (match_length == 0) {
+      return read == size ? (ssize_t) written : -1;
+    }
+
+    if (size - read < sizeof(uint16_t)) {
+      return -1;
+    }
+    size_t offset = (uint8_t) source[read] | (uint8_t) source[read + 1] << 8;
+    read += sizeof(uint16_t);
+
+    if (match_length == 15
+        && !lz_read_length(source, size, &read, &match_length)) {
+      return -1;
+    }
+    match_length += LZ_MIN_MATCH - 1;
+
+    if (offset == 0 || offset > written
+        || match_length > capacity - written) {
+      return -1;
+    }
+
+    for (size_t i = 0; i < match_length; ++i, ++written) {
+      dest[written] = dest[written - offset];
+    }
+  }
+
+  return -1;
+}
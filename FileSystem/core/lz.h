@@ -0,0 +1,45 @@
+/**
+ * @file lz.h
+ * @author yaishenka
+ * @date 19.10.2026
+ * @brief Contains LZ77 codec used for compressed files
+ *
+ * Stream is a sequence of tokens. High nibble of token is literals length,
+ * low nibble is match length - LZ_MIN_MATCH + 1, zero low nibble ends stream.
+ * Nibble 15 is followed by bytes of extra length (255 means continue).
+ * Literals follow token, then 2 bytes of little-endian match offset
+ */
+#ifndef EXT_FILESYSTEM_CORE_LZ_H_
+#define EXT_FILESYSTEM_CORE_LZ_H_
+#include <stdint.h>
+#include <stdbool.h>
+#include <unistd.h>
+
+#define LZ_MIN_MATCH 4
+#define LZ_HASH_BITS 12
+#define LZ_MAX_OFFSET UINT16_MAX
+
+/**
+ * @brief Compress data
+ * @param source
+ * @param size
+ * @param dest
+ * @param capacity size of dest
+ * @return size of compressed data; 0 if it doesn't fit in capacity
+ */
+size_t lz_compress(const char* source, size_t size, char* dest, size_t capacity);
+
+/**
+ * @brief Decompress data compressed with lz_compress()
+ * @param source
+ * @param size
+ * @param dest
+ * @param capacity size of dest
+ * @return size of decompressed data; -1 if stream is corrupted
+ */
+ssize_t lz_decompress(const char* source,
+                      size_t size,
+                      char* dest,
+                      size_t capacity);
+
+#endif //EXT_FILESYSTEM_CORE_LZ_H_
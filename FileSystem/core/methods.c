@@ -3,7 +3,19 @@
 
 #include "methods.h"
 #include "../utils.h"
+#include "arena.h"
 #include "defines.h"
+#include "layout.h"
+
+bool is_special_record(const char* name) {
+  return strcmp(name, ".") == 0 || strcmp(name, "..") == 0;
+}
+
+uint16_t get_special_record_inode_id(const struct inode* inode,
+                                     const char* name) {
+  return strcmp(name, ".") == 0
+      ? inode->inode_info->id : inode->inode_info->parent_id;
+}
 
 uint16_t create_dir_helper(const int fd,
                            const struct superblock* superblock,
@@ -27,41 +39,27 @@ uint16_t create_dir_helper(const int fd,
   }
 
   struct inode inode;
-  init_inode(&inode, new_inode_id, false, superblock);
+  init_inode(&inode, new_inode_id, false);
   inode.block_ids[0] = new_block_id;
   inode.inode_info->blocks_count = 1;
+  inode.inode_info->parent_id = parent_node_id;
 
   struct block block;
-  init_block_with_records(&block, superblock, new_block_id, new_inode_id, 2);
-
-  struct block_record dot_record;
-  init_block_record(&dot_record, superblock, new_inode_id);
-  memcpy(dot_record.path, ".", 1);
-  block.block_records[0] = dot_record;
-
-  struct block_record two_dots_record;
-  init_block_record(&two_dots_record, superblock, parent_node_id);
-  memcpy(two_dots_record.path, "..", 2);
-  block.block_records[1] = two_dots_record;
+  init_block_with_records(&block, superblock, new_block_id, new_inode_id);
 
   if (write_block(fd, &block, superblock) == -1) {
     fprintf(stderr, "Can't write block. Abort!\n");
     free_inode(superblock, new_inode_id);
     free_block(superblock, new_block_id);
-    destroy_inode(&inode);
-    destruct_block(&block);
     return superblock->fs_info->inodes_count;
   }
-  destruct_block(&block);
 
   if (write_inode(fd, &inode, superblock) == -1) {
     fprintf(stderr, "Can't write inode. Abort!\n");
     free_inode(superblock, new_inode_id);
     free_block(superblock, new_block_id);
-    destroy_inode(&inode);
     return superblock->fs_info->inodes_count;
   }
-  destroy_inode(&inode);
 
   if (write_super_block(fd, superblock) == -1) {
     fprintf(stderr, "Can't write superblock. Abort!\n");
@@ -82,50 +80,72 @@ uint16_t create_file_helper(int fd,
     return superblock->fs_info->inodes_count;
   }
 
-  uint16_t new_block_id = reserve_block(superblock);
-  if (new_block_id == superblock->fs_info->blocks_count) {
-    fprintf(stderr, "Can't create more blocks. Abort!\n");
-    free_inode(superblock, new_inode_id);
-    return superblock->fs_info->inodes_count;
-  }
-
   struct inode inode;
-  init_inode(&inode, new_inode_id, true, superblock);
-  inode.block_ids[0] = new_block_id;
-  inode.inode_info->blocks_count = 1;
-
-  struct block block;
-  init_block(&block, superblock, new_block_id, new_inode_id);
-
-  if (write_block(fd, &block, superblock) == -1) {
-    fprintf(stderr, "Can't write block. Abort!\n");
-    free_inode(superblock, new_inode_id);
-    free_block(superblock, new_block_id);
-    destroy_inode(&inode);
-    destruct_block(&block);
-    return superblock->fs_info->inodes_count;
-  }
-  destruct_block(&block);
+  init_inode(&inode, new_inode_id, true);
+  inode.inode_info->flags |= INODE_FLAG_INLINE;
 
   if (write_inode(fd, &inode, superblock) == -1) {
     fprintf(stderr, "Can't write inode. Abort!\n");
     free_inode(superblock, new_inode_id);
-    free_block(superblock, new_block_id);
-    destroy_inode(&inode);
     return superblock->fs_info->inodes_count;
   }
-  destroy_inode(&inode);
 
   if (write_super_block(fd, superblock) == -1) {
     fprintf(stderr, "Can't write superblock. Abort!\n");
     free_inode(superblock, new_inode_id);
-    free_block(superblock, new_block_id);
     return superblock->fs_info->inodes_count;
   }
 
   return new_inode_id;
 }
 
+bool discard_new_inode(const int fd,
+                       const struct superblock* superblock,
+                       uint16_t inode_id) {
+  struct inode inode;
+  if (read_inode(fd, &inode, inode_id, superblock) == -1) {
+    fprintf(stderr, "Can't read inode. Abort!\n");
+    return false;
+  }
+
+  for (uint16_t i = 0; i < inode.inode_info->blocks_count; ++i) {
+    if (inode.block_ids[i] != superblock->fs_info->blocks_count) {
+      release_block(superblock, inode.block_ids[i]);
+    }
+  }
+  free_inode(superblock, inode_id);
+
+  return write_super_block(fd, superblock) != -1;
+}
+
+bool write_directory_block(const int fd,
+                           const struct superblock* superblock,
+                           struct inode* inode,
+                           struct block* block) {
+  uint16_t block_id = block->block_info->block_id;
+  if (!is_shared_block(superblock, block_id)) {
+    return write_block(fd, block, superblock) != -1;
+  }
+
+  uint16_t new_block_id = reserve_block(superblock);
+  if (new_block_id == superblock->fs_info->blocks_count) {
+    fprintf(stderr, "Can't create more blocks. Abort!\n");
+    return false;
+  }
+
+  block->block_info->block_id = new_block_id;
+  block->block_info->inode_id = inode->inode_info->id;
+  if (write_block(fd, block, superblock) == -1) {
+    free_block(superblock, new_block_id);
+    return false;
+  }
+
+  release_block(superblock, block_id);
+  inode->block_ids[0] = new_block_id;
+  return write_inode(fd, inode, superblock) != -1
+      && write_super_block(fd, superblock) != -1;
+}
+
 bool get_inode_id_of_dir_rec(const int fd,
                              const char* path,
                              uint16_t* current_inode_id,
@@ -138,60 +158,29 @@ bool get_inode_id_of_dir_rec(const int fd,
 
   if (inode.inode_info->is_file) {
     fprintf(stderr, "Trying to list file. Abort!\n");
-    destroy_inode(&inode);
     return false;
   }
 
   char* current_file_name =
-      (char*) calloc(superblock->fs_info->max_path_len, sizeof(char));
+      (char*) arena_calloc(superblock->fs_info->max_path_len, sizeof(char));
   char* path_to_parse = parse_path(path, current_file_name);
 
   if (strcmp(current_file_name, "/") == 0) {
-    destroy_inode(&inode);
-    free(current_file_name);
     return true;
   }
 
-  struct block block;
-  read_block(fd, &block, inode.block_ids[0], superblock);
-
-  bool founded = false;
-  uint16_t right_record_id = 0;
-
-  for (; right_record_id < block.block_info->records_count; ++right_record_id) {
-    if (strcmp(block.block_records[right_record_id].path, current_file_name)
-        == 0) {
-      founded = true;
-      break;
-    }
-  }
-
-  if (!founded) {
+  *current_inode_id =
+      get_file_inode_id(fd, &inode, current_file_name, superblock);
+  if (*current_inode_id == superblock->fs_info->inodes_count) {
     fprintf(stderr, "Directory doesn't exist. Abort!\n");
-    destruct_block(&block);
-    destroy_inode(&inode);
-    free(current_file_name);
     return false;
   }
 
-  *current_inode_id = block.block_records[right_record_id].inode_id;
-
   if (path_to_parse == NULL) {
-    destruct_block(&block);
-    destroy_inode(&inode);
-    free(current_file_name);
     return true;
-  } else {
-    bool result = get_inode_id_of_dir_rec(fd,
-                                          path_to_parse,
-                                          current_inode_id,
-                                          superblock);
-    destruct_block(&block);
-    destroy_inode(&inode);
-    free(current_file_name);
-    return result;
   }
 
+  return get_inode_id_of_dir_rec(fd, path_to_parse, current_inode_id, superblock);
 }
 
 uint16_t get_inode_id_of_dir(const int fd,
@@ -211,43 +200,133 @@ bool is_dir_exist(const int fd,
                   struct inode* inode,
                   const char* dirname,
                   const struct superblock* superblock) {
-  struct block block;
-  if (read_block(fd, &block, inode->block_ids[0], superblock) == -1) {
-    fprintf(stderr, "Can't read block. Abort without cleaning!\n");
-    exit(EXIT_FAILURE);
-  }
-
-  for (uint16_t record_id = 0; record_id < block.block_info->records_count;
-       ++record_id) {
-    if (strcmp(dirname, block.block_records[record_id].path) == 0) {
-      destruct_block(&block);
-      return true;
-    }
-  }
-
-  destruct_block(&block);
-  return false;
+  return get_file_inode_id(fd, inode, dirname, superblock)
+      != superblock->fs_info->inodes_count;
 }
 
 uint16_t get_file_inode_id(const int fd,
                            struct inode* inode,
                            const char* dirname,
                            const struct superblock* superblock) {
+  if (is_special_record(dirname)) {
+    return get_special_record_inode_id(inode, dirname);
+  }
+
   struct block block;
   if (read_block(fd, &block, inode->block_ids[0], superblock) == -1) {
-    fprintf(stderr, "Can't read block. Abort without cleaning!\n");
-    exit(EXIT_FAILURE);
+    fprintf(stderr, "Can't read block. Abort!\n");
+    return superblock->fs_info->inodes_count;
   }
 
   for (uint16_t record_id = 0; record_id < block.block_info->records_count;
        ++record_id) {
     if (strcmp(dirname, block.block_records[record_id].path) == 0) {
       uint16_t inode_id = block.block_records[record_id].inode_id;
-      destruct_block(&block);
       return inode_id;
     }
   }
 
-  destruct_block(&block);
   return superblock->fs_info->inodes_count;
-}
\ No newline at end of file
+}
+
+bool orphan_inode(const int fd,
+                  const struct superblock* superblock,
+                  const struct descriptors_table* descriptors_table,
+                  uint16_t inode_id,
+                  bool recursive) {
+  struct inode inode;
+  if (read_inode(fd, &inode, inode_id, superblock) == -1) {
+    fprintf(stderr, "Can't read inode. Abort!\n");
+    return false;
+  }
+
+  if (inode.inode_info->is_file) {
+    if (is_inode_opened(descriptors_table, inode_id, superblock)) {
+      fprintf(stderr, "File is opened. Abort!\n");
+      return false;
+    }
+  } else {
+    struct block block;
+    if (read_block(fd, &block, inode.block_ids[0], superblock) == -1) {
+      fprintf(stderr, "Can't read block. Abort!\n");
+      return false;
+    }
+
+    for (uint8_t record_id = 0; record_id < block.block_info->records_count;
+         ++record_id) {
+      if (!recursive) {
+        fprintf(stderr, "Directory isn't empty. Abort!\n");
+        return false;
+      }
+
+      if (!orphan_inode(fd,
+                        superblock,
+                        descriptors_table,
+                        block.block_records[record_id].inode_id,
+                        recursive)) {
+        return false;
+      }
+    }
+  }
+
+  superblock->orphan_inodes_mask[inode_id] = true;
+  return true;
+}
+
+uint16_t reclaim_orphans(const int fd, const struct superblock* superblock) {
+  uint16_t blocks_count = superblock->fs_info->blocks_count;
+  bool* released_blocks = (bool*) arena_calloc(blocks_count, sizeof(bool));
+  uint16_t reclaimed = 0;
+
+  for (uint16_t inode_id = 0; inode_id < superblock->fs_info->inodes_count;
+       ++inode_id) {
+    if (!superblock->orphan_inodes_mask[inode_id]) {
+      continue;
+    }
+
+    struct inode inode;
+    if (read_inode(fd, &inode, inode_id, superblock) == -1) {
+      fprintf(stderr, "Can't read inode. Skip!\n");
+      continue;
+    }
+
+    if (!is_inline_inode(&inode)) {
+      uint16_t cluster_size = get_inode_cluster_size(&inode, superblock);
+      for (uint16_t index = 0; index < inode.inode_info->blocks_count;
+           ++index) {
+        if (inode.block_ids[index] >= blocks_count) {
+          continue;
+        }
+
+        for (uint16_t i = 0; i < cluster_size; ++i) {
+          uint16_t block_id = inode.block_ids[index] + i;
+          if (release_block(superblock, block_id)) {
+            released_blocks[block_id] = true;
+          }
+        }
+      }
+    }
+
+    free_inode(superblock, inode_id);
+    ++reclaimed;
+  }
+
+  for (uint16_t run_start = 0; run_start < blocks_count;) {
+    if (!released_blocks[run_start]) {
+      ++run_start;
+      continue;
+    }
+
+    uint16_t run_end = run_start;
+    while (run_end < blocks_count && released_blocks[run_end]) {
+      ++run_end;
+    }
+
+    punch_hole(fd,
+               get_block_offset(superblock, run_start),
+               (off_t) (run_end - run_start) * superblock->fs_info->block_size);
+    run_start = run_end;
+  }
+
+  return reclaimed;
+}
@@ -11,11 +11,29 @@
 #include "superblock.h"
 #include "block.h"
 #include "inode.h"
+#include "descriptors_table.h"
+
+/**
+ * @brief Check if name is "." or ".."
+ * Such records aren't stored in directory blocks
+ * @param name
+ * @return
+ */
+bool is_special_record(const char* name);
+
+/**
+ * @brief Resolve "." or ".." of directory
+ * @param inode directory inode
+ * @param name "." or ".."
+ * @return id of directory itself or of its parent
+ */
+uint16_t get_special_record_inode_id(const struct inode* inode,
+                                     const char* name);
 
 /**
  * @brief Helper for create new directory
  * Creates dir with parent = parent_node_id (or itself if is_root).
- * Push to new dir records about "." and ".."
+ * New dir has empty directory block: "." and ".." aren't stored
  * @param fd opened fd
  * @param superblock
  * @param parent_node_id parent of new dir
@@ -29,7 +47,8 @@ uint16_t create_dir_helper(int fd,
 
 /**
  * @brief Helper for create new file
- * Creates file with parent = parent_node_id
+ * Creates file with parent = parent_node_id.
+ * New file is empty inline file, so it has no blocks
  * @param fd
  * @param superblock
  * @param parent_node_id
@@ -39,6 +58,34 @@ uint16_t create_file_helper(int fd,
                             const struct superblock* superblock,
                             uint16_t parent_node_id);
 
+/**
+ * @brief Release just created inode which didn't get directory record
+ * Inode and its blocks are freed and superblock is written,
+ * so inode isn't leaked till fsck
+ * @param fd
+ * @param superblock
+ * @param inode_id id returned by create_dir_helper() or create_file_helper()
+ * @return true if all ok; false otherwise
+ */
+bool discard_new_inode(int fd,
+                       const struct superblock* superblock,
+                       uint16_t inode_id);
+
+/**
+ * @brief Write changed directory block of inode
+ * Shared block (see core/snapshot.h) isn't changed in place: it is copied
+ * to new block, inode and superblock are written in this case
+ * @param fd
+ * @param superblock
+ * @param inode directory inode
+ * @param block first block of inode
+ * @return true if all ok; false otherwise
+ */
+bool write_directory_block(int fd,
+                           const struct superblock* superblock,
+                           struct inode* inode,
+                           struct block* block);
+
 /**
  * @brief Parse path and find inode of this dir
  * @param fd
@@ -70,10 +117,40 @@ bool is_dir_exist(int fd,
  * @param dirname
  * @param superblock
  * @return inode_id of file if it exists in this node; superblock->fs_info.inodes_count otherwise
+ * (also if block of directory can't be read)
  */
 uint16_t get_file_inode_id(int fd,
                            struct inode* inode,
                            const char* dirname,
                            const struct superblock* superblock);
 
+/**
+ * @brief Mark inode as orphan
+ * Orphan is deleted but its inode and blocks are released later by
+ * reclaim_orphans(). With recursive all inodes of directory are marked too.
+ * Nothing is written: caller writes superblock if all ok
+ * @param fd opened fd
+ * @param superblock
+ * @param descriptors_table
+ * @param inode_id
+ * @param recursive
+ * @return true if all ok; false if directory isn't empty or file is opened
+ */
+bool orphan_inode(int fd,
+                  const struct superblock* superblock,
+                  const struct descriptors_table* descriptors_table,
+                  uint16_t inode_id,
+                  bool recursive);
+
+/**
+ * @brief Release orphan inodes and their blocks
+ * Released blocks are hole punched in image, so image takes less space on
+ * host. If host FS can't punch holes blocks are released anyway.
+ * Superblock should be written by caller
+ * @param fd opened fd
+ * @param superblock
+ * @return count of released inodes
+ */
+uint16_t reclaim_orphans(int fd, const struct superblock* superblock);
+
 #endif //EXT_FILESYSTEM_CORE_METHODS_H_
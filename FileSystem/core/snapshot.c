@@ -0,0 +1,298 @@
+/** @author yaishenka
+    @date 19.10.2026 */
+
+#include <stdio.h>
+#include <string.h>
+#include "snapshot.h"
+#include "inode.h"
+#include "block.h"
+#include "arena.h"
+#include "layout.h"
+#include "../utils.h"
+
+static _Thread_local char mounted_snapshot[MAX_PATH_LEN] = "";
+
+size_t get_snapshot_size(const struct superblock* superblock) {
+  return superblock->fs_info->inodes_count
+      * (sizeof(bool) + get_inode_size(superblock));
+}
+
+uint16_t get_snapshot_blocks_count(const struct superblock* superblock) {
+  uint32_t max_data_in_block = get_max_data_in_block(superblock);
+  return (get_snapshot_size(superblock) + max_data_in_block - 1)
+      / max_data_in_block;
+}
+
+struct snapshot_info* find_snapshot(const struct superblock* superblock,
+                                    const char* name) {
+  for (uint16_t i = 0; i < SNAPSHOTS_COUNT; ++i) {
+    struct snapshot_info* snapshot = &superblock->snapshots[i];
+    if (snapshot->blocks_count != 0
+        && strncmp(snapshot->name, name, MAX_PATH_LEN) == 0) {
+      return snapshot;
+    }
+  }
+
+  return NULL;
+}
+
+bool is_snapshot_block(const struct superblock* superblock, uint16_t block_id) {
+  for (uint16_t i = 0; i < SNAPSHOTS_COUNT; ++i) {
+    const struct snapshot_info* snapshot = &superblock->snapshots[i];
+    if (snapshot->blocks_count != 0
+        && block_id >= snapshot->first_block_id
+        && block_id - snapshot->first_block_id < snapshot->blocks_count) {
+      return true;
+    }
+  }
+
+  return false;
+}
+
+char* read_snapshot(const int fd,
+                    const struct superblock* superblock,
+                    const struct snapshot_info* snapshot) {
+  size_t block_size = sizeof_block(superblock);
+  char* blocks =
+      (char*) arena_calloc(snapshot->blocks_count * block_size, sizeof(char));
+  if (read_blocks_run(fd,
+                      superblock,
+                      snapshot->first_block_id,
+                      snapshot->blocks_count,
+                      blocks) == -1) {
+    fprintf(stderr, "Can't read snapshot. Abort!\n");
+    return NULL;
+  }
+
+  size_t size = get_snapshot_size(superblock);
+  char* data = (char*) arena_calloc(size, sizeof(char));
+  size_t total_read = 0;
+  for (uint16_t i = 0; i < snapshot->blocks_count; ++i) {
+    char* record = blocks + i * block_size;
+    struct block_info* block_info = (struct block_info*) record;
+    if (!is_record_checksum_valid(record, block_size)
+        || block_info->block_id != snapshot->first_block_id + i
+        || block_info->data_size > size - total_read) {
+      fprintf(stderr, "Snapshot is corrupted. Abort!\n");
+      return NULL;
+    }
+
+    memcpy(data + total_read,
+           record + sizeof(struct block_info),
+           block_info->data_size);
+    total_read += block_info->data_size;
+  }
+
+  if (total_read != size) {
+    fprintf(stderr, "Snapshot is corrupted. Abort!\n");
+    return NULL;
+  }
+
+  return data;
+}
+
+ssize_t create_snapshot(const int fd,
+                        const struct superblock* superblock,
+                        const char* name) {
+  uint16_t inodes_count = superblock->fs_info->inodes_count;
+  uint16_t blocks_count = superblock->fs_info->blocks_count;
+  size_t inode_size = get_inode_size(superblock);
+
+  if (strlen(name) == 0 || strlen(name) >= MAX_PATH_LEN) {
+    fprintf(stderr, "Bad snapshot name. Abort!\n");
+    return -1;
+  }
+
+  if (find_snapshot(superblock, name) != NULL) {
+    fprintf(stderr, "Snapshot already exists. Abort!\n");
+    return -1;
+  }
+
+  struct snapshot_info* snapshot = NULL;
+  for (uint16_t i = 0; i < SNAPSHOTS_COUNT && snapshot == NULL; ++i) {
+    if (superblock->snapshots[i].blocks_count == 0) {
+      snapshot = &superblock->snapshots[i];
+    }
+  }
+
+  if (snapshot == NULL) {
+    fprintf(stderr, "Can't create more snapshots. Abort!\n");
+    return -1;
+  }
+
+  size_t size = get_snapshot_size(superblock);
+  char* data = (char*) arena_calloc(size, sizeof(char));
+  bool* inodes_mask = (bool*) data;
+  char* inodes = data + inodes_count;
+  if (read_inodes_table(fd, superblock, inodes) == -1) {
+    fprintf(stderr, "Can't read inodes. Abort!\n");
+    return -1;
+  }
+
+  uint16_t* new_references =
+      (uint16_t*) arena_calloc(blocks_count, sizeof(uint16_t));
+  for (uint16_t inode_id = 0; inode_id < inodes_count; ++inode_id) {
+    inodes_mask[inode_id] = superblock->reserved_inodes_mask[inode_id]
+        && !superblock->orphan_inodes_mask[inode_id];
+    if (!inodes_mask[inode_id]) {
+      continue;
+    }
+
+    struct inode inode;
+    memcpy(inode.record, inodes + inode_id * inode_size, inode_size);
+    init_inode_views(&inode);
+    if (is_inline_inode(&inode)) {
+      continue;
+    }
+
+    uint16_t cluster_size = get_inode_cluster_size(&inode, superblock);
+    for (uint16_t index = 0; index < inode.inode_info->blocks_count; ++index) {
+      if (inode.block_ids[index] >= blocks_count) {
+        continue;
+      }
+
+      for (uint16_t i = 0; i < cluster_size; ++i) {
+        uint16_t block_id = inode.block_ids[index] + i;
+        new_references[block_id] += 1;
+        if (superblock->block_references[block_id] + new_references[block_id]
+            > UINT8_MAX) {
+          fprintf(stderr, "Block has too many references. Abort!\n");
+          return -1;
+        }
+      }
+    }
+  }
+
+  uint16_t snapshot_blocks_count = get_snapshot_blocks_count(superblock);
+  uint16_t first_block_id =
+      find_free_blocks_run(superblock, 0, snapshot_blocks_count);
+  if (first_block_id == blocks_count) {
+    fprintf(stderr, "Can't create more blocks in FS. Abort!\n");
+    return -1;
+  }
+
+  size_t block_size = sizeof_block(superblock);
+  uint32_t max_data_in_block = get_max_data_in_block(superblock);
+  char* blocks = (char*) arena_calloc(snapshot_blocks_count * block_size,
+                                      sizeof(char));
+  for (uint16_t i = 0; i < snapshot_blocks_count; ++i) {
+    char* record = blocks + i * block_size;
+    size_t offset = (size_t) i * max_data_in_block;
+    size_t chunk = size - offset < max_data_in_block
+                   ? size - offset : max_data_in_block;
+
+    struct block_info* block_info = (struct block_info*) record;
+    block_info->block_id = first_block_id + i;
+    block_info->inode_id = inodes_count;
+    block_info->data_size = chunk;
+    memcpy(record + sizeof(struct block_info), data + offset, chunk);
+  }
+
+  if (write_blocks_run(fd,
+                       superblock,
+                       first_block_id,
+                       snapshot_blocks_count,
+                       blocks) == -1) {
+    fprintf(stderr, "Can't write snapshot. Abort!\n");
+    return -1;
+  }
+
+  for (uint16_t i = 0; i < snapshot_blocks_count; ++i) {
+    superblock->reserved_blocks_mask[first_block_id + i] = true;
+  }
+  for (uint16_t block_id = 0; block_id < blocks_count; ++block_id) {
+    superblock->block_references[block_id] += new_references[block_id];
+  }
+
+  memset(snapshot->name, 0, MAX_PATH_LEN);
+  memcpy(snapshot->name, name, strlen(name));
+  snapshot->first_block_id = first_block_id;
+  snapshot->blocks_count = snapshot_blocks_count;
+
+  return snapshot_blocks_count;
+}
+
+bool delete_snapshot(const int fd,
+                     const struct superblock* superblock,
+                     const char* name) {
+  struct snapshot_info* snapshot = find_snapshot(superblock, name);
+  if (snapshot == NULL) {
+    fprintf(stderr, "Snapshot doesn't exist. Abort!\n");
+    return false;
+  }
+
+  char* data = read_snapshot(fd, superblock, snapshot);
+  if (data == NULL) {
+    return false;
+  }
+
+  uint16_t inodes_count = superblock->fs_info->inodes_count;
+  uint16_t blocks_count = superblock->fs_info->blocks_count;
+  size_t inode_size = get_inode_size(superblock);
+  for (uint16_t inode_id = 0; inode_id < inodes_count; ++inode_id) {
+    if (!data[inode_id]) {
+      continue;
+    }
+
+    struct inode inode;
+    memcpy(inode.record, data + inodes_count + inode_id * inode_size,
+           inode_size);
+    init_inode_views(&inode);
+    if (is_inline_inode(&inode)) {
+      continue;
+    }
+
+    uint16_t cluster_size = get_inode_cluster_size(&inode, superblock);
+    for (uint16_t index = 0; index < inode.inode_info->blocks_count; ++index) {
+      if (inode.block_ids[index] >= blocks_count) {
+        continue;
+      }
+
+      for (uint16_t i = 0; i < cluster_size; ++i) {
+        release_block(superblock, inode.block_ids[index] + i);
+      }
+    }
+  }
+
+  for (uint16_t i = 0; i < snapshot->blocks_count; ++i) {
+    free_block(superblock, snapshot->first_block_id + i);
+  }
+  memset(snapshot, 0, sizeof(struct snapshot_info));
+
+  return true;
+}
+
+void mount_snapshot(const char* name) {
+  memset(mounted_snapshot, 0, MAX_PATH_LEN);
+  if (name != NULL) {
+    strncpy(mounted_snapshot, name, MAX_PATH_LEN - 1);
+  }
+}
+
+bool is_snapshot_mounted(void) {
+  return mounted_snapshot[0] != '\0';
+}
+
+bool load_mounted_snapshot(const int fd, struct superblock* superblock) {
+  if (!is_snapshot_mounted()) {
+    return true;
+  }
+
+  struct snapshot_info* snapshot = find_snapshot(superblock, mounted_snapshot);
+  if (snapshot == NULL) {
+    fprintf(stderr, "Snapshot doesn't exist. Abort!\n");
+    return false;
+  }
+
+  char* data = read_snapshot(fd, superblock, snapshot);
+  if (data == NULL) {
+    return false;
+  }
+
+  uint16_t inodes_count = superblock->fs_info->inodes_count;
+  superblock->reserved_inodes_mask = (bool*) data;
+  superblock->orphan_inodes_mask =
+      (bool*) arena_calloc(inodes_count, sizeof(bool));
+  superblock->snapshot_inodes = data + inodes_count;
+  return true;
+}
@@ -0,0 +1,95 @@
+/**
+ * @file snapshot.h
+ * @author yaishenka
+ * @date 19.10.2026
+ * @brief Contains methods to take and mount snapshots of FS
+ *
+ * Snapshot is a copy of inodes mask and inodes table stored in contiguous
+ * run of blocks. Blocks of files aren't copied: every block referenced by
+ * snapshot gets one more reference (see superblock->block_references),
+ * so it is copied on next change (see write_inode_data() and
+ * write_directory_block()) and released when snapshot is removed
+ */
+#ifndef EXT_FILESYSTEM_CORE_SNAPSHOT_H_
+#define EXT_FILESYSTEM_CORE_SNAPSHOT_H_
+#include <stdint.h>
+#include <stdbool.h>
+#include <unistd.h>
+#include "superblock.h"
+
+/**
+ * @brief Find snapshot by name
+ * @param superblock
+ * @param name
+ * @return snapshot if it exists; NULL otherwise
+ */
+struct snapshot_info* find_snapshot(const struct superblock* superblock,
+                                    const char* name);
+
+/**
+ * @brief Check if block stores inodes of some snapshot
+ * Such blocks are owned by nobody like tail blocks, so they must be
+ * told apart by this check
+ * @param superblock
+ * @param block_id
+ * @return true if block belongs to snapshot; false otherwise
+ */
+bool is_snapshot_block(const struct superblock* superblock, uint16_t block_id);
+
+/**
+ * @brief Read inodes mask and inodes table of snapshot
+ * @param fd opened fd
+ * @param superblock
+ * @param snapshot
+ * @return inodes mask followed by inodes table if all ok; NULL otherwise
+ */
+char* read_snapshot(int fd,
+                    const struct superblock* superblock,
+                    const struct snapshot_info* snapshot);
+
+/**
+ * @brief Take snapshot of current FS
+ * Inodes table is read and written with one pread and one pwrite.
+ * Superblock should be written by caller
+ * @param fd opened fd
+ * @param superblock
+ * @param name
+ * @return count of blocks used by snapshot if all ok; -1 otherwise
+ */
+ssize_t create_snapshot(int fd,
+                        const struct superblock* superblock,
+                        const char* name);
+
+/**
+ * @brief Remove snapshot and release its references
+ * Superblock should be written by caller
+ * @param fd opened fd
+ * @param superblock
+ * @param name
+ * @return true if all ok; false otherwise
+ */
+bool delete_snapshot(int fd,
+                     const struct superblock* superblock,
+                     const char* name);
+
+/**
+ * @brief Mount snapshot read-only for current thread
+ * Every next read_super_block() of this thread loads snapshot
+ * @param name name of snapshot; NULL to mount current FS
+ */
+void mount_snapshot(const char* name);
+
+/**
+ * @return true if snapshot is mounted in current thread
+ */
+bool is_snapshot_mounted(void);
+
+/**
+ * @brief Load mounted snapshot into superblock
+ * @param fd opened fd
+ * @param superblock
+ * @return true if all ok or nothing is mounted; false otherwise
+ */
+bool load_mounted_snapshot(int fd, struct superblock* superblock);
+
+#endif //EXT_FILESYSTEM_CORE_SNAPSHOT_H_
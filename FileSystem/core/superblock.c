@@ -7,109 +7,262 @@
 #include <string.h>
 #include "superblock.h"
 #include "defines.h"
+#include "arena.h"
+#include "layout.h"
+#include "snapshot.h"
 #include "../utils.h"
 
-void init_superblock_arrays(struct superblock* superblock) {
-  superblock->reserved_blocks_mask =
-      (bool*) calloc(superblock->fs_info->blocks_count, sizeof(bool));
+void init_superblock_views(struct superblock* superblock) {
+  superblock->fs_info = (struct fs_info*) superblock->record;
   superblock->reserved_inodes_mask =
-      (bool*) calloc(superblock->fs_info->inodes_count, sizeof(bool));
+      (bool*) (superblock->record + sizeof(struct fs_info));
+  superblock->reserved_blocks_mask =
+      superblock->reserved_inodes_mask + superblock->fs_info->inodes_count;
+  superblock->unwritten_blocks_mask =
+      superblock->reserved_blocks_mask + superblock->fs_info->blocks_count;
+  superblock->orphan_inodes_mask =
+      superblock->unwritten_blocks_mask + superblock->fs_info->blocks_count;
+  superblock->block_references = (uint8_t*) (superblock->orphan_inodes_mask
+      + superblock->fs_info->inodes_count);
+  superblock->snapshots = (struct snapshot_info*) (superblock->block_references
+      + superblock->fs_info->blocks_count);
+  superblock->block_fingerprints = NULL;
+  if (superblock->fs_info->flags & FS_FLAG_DEDUP) {
+    superblock->block_fingerprints =
+        (char*) (superblock->snapshots + SNAPSHOTS_COUNT);
+  }
+  superblock->backing_path = NULL;
+  if (superblock->fs_info->flags & FS_FLAG_OVERLAY) {
+    superblock->backing_path = superblock->record
+        + get_superblock_record_size(superblock->fs_info->inodes_count,
+                                     superblock->fs_info->blocks_count,
+                                     superblock->fs_info->flags)
+        - BACKING_PATH_LEN;
+  }
+  superblock->snapshot_inodes = NULL;
 }
 
-void init_superblock_fs_info(struct superblock* superblock) {
-  superblock->fs_info = (struct fs_info*) calloc(1, sizeof(struct fs_info));
+size_t get_superblock_record_size(uint16_t inodes_count,
+                                  uint16_t blocks_count,
+                                  uint16_t flags) {
+  size_t size = sizeof(struct fs_info)
+      + 2 * sizeof(bool) * inodes_count
+      + 2 * sizeof(bool) * blocks_count
+      + sizeof(uint8_t) * blocks_count
+      + sizeof(struct snapshot_info) * SNAPSHOTS_COUNT;
+  if (flags & FS_FLAG_DEDUP) {
+    size += sizeof(uint32_t) * blocks_count;
+  }
+  if (flags & FS_FLAG_OVERLAY) {
+    size += BACKING_PATH_LEN;
+  }
+
+  return size;
 }
 
 size_t sizeof_superblock(const struct superblock* superblock) {
-  return sizeof(struct fs_info)
-      + sizeof(bool) * superblock->fs_info->inodes_count
-      + sizeof(bool) * superblock->fs_info->blocks_count;
+  return get_superblock_record_size(superblock->fs_info->inodes_count,
+                                    superblock->fs_info->blocks_count,
+                                    superblock->fs_info->flags);
 }
 
-void init_super_block(struct superblock* superblock) {
-  init_superblock_fs_info(superblock);
+void init_super_block(struct superblock* superblock,
+                      uint16_t flags,
+                      uint16_t inodes_count,
+                      uint16_t blocks_count) {
+  superblock->record = (char*) arena_calloc(
+      get_superblock_record_size(inodes_count, blocks_count, flags),
+      sizeof(char));
+  superblock->backing = NULL;
+  superblock->backing_fd = -1;
+  superblock->fs_info = (struct fs_info*) superblock->record;
   superblock->fs_info->blocks_count_in_inode = BLOCKS_COUNT_IN_INODE;
-  superblock->fs_info->blocks_count = BLOCKS_COUNT;
-  superblock->fs_info->inodes_count = INODES_COUNT;
+  superblock->fs_info->blocks_count = blocks_count;
+  superblock->fs_info->inodes_count = inodes_count;
+  superblock->fs_info->initialized_inodes = 0;
   superblock->fs_info->block_size = BLOCK_SIZE;
   superblock->fs_info->max_path_len = MAX_PATH_LEN;
   superblock->fs_info->descriptors_count = DESCRIPTORS_COUNT;
   superblock->fs_info->magic = MAGIC;
-  init_superblock_arrays(superblock);
+  superblock->fs_info->flags = flags;
+  if (flags & FS_FLAG_ALIGNED) {
+    superblock->fs_info->block_size = ALIGNED_BLOCK_SIZE;
+  }
+  init_superblock_views(superblock);
+  init_layout(superblock);
+  superblock->block_table =
+      (char*) arena_calloc(blocks_count, sizeof(struct block_info));
+  init_fingerprint_buckets(superblock);
 }
 
 void destroy_super_block(struct superblock* superblock) {
-  free(superblock->fs_info);
-  free(superblock->reserved_blocks_mask);
-  free(superblock->reserved_inodes_mask);
+  for (struct superblock* image = superblock;
+       image->backing != NULL;
+       image = image->backing) {
+    close(image->backing_fd);
+  }
+  superblock->backing = NULL;
+  superblock->backing_fd = -1;
+  superblock->fs_info = NULL;
+  superblock->reserved_blocks_mask = NULL;
+  superblock->reserved_inodes_mask = NULL;
+  superblock->unwritten_blocks_mask = NULL;
+  superblock->orphan_inodes_mask = NULL;
+  superblock->block_references = NULL;
+  superblock->snapshots = NULL;
+  superblock->block_fingerprints = NULL;
+  superblock->fingerprint_buckets = NULL;
+  superblock->fingerprint_chains = NULL;
+  superblock->record = NULL;
+  superblock->snapshot_inodes = NULL;
+  superblock->block_table = NULL;
+  superblock->backing_path = NULL;
+  reset_arena();
 }
 
-ssize_t read_super_block(const int fd, struct superblock* superblock) {
-  init_superblock_fs_info(superblock);
-  lseek(fd, 0, SEEK_SET);
-  ssize_t total_read =
-      read_while(fd, (char*) superblock->fs_info, sizeof(struct fs_info));
+ssize_t read_super_block_record(int fd, struct superblock* superblock);
+
+bool open_backing_image(struct superblock* superblock) {
+  if (!(superblock->fs_info->flags & FS_FLAG_OVERLAY)) {
+    return true;
+  }
+
+  superblock->backing_path[BACKING_PATH_LEN - 1] = '\0';
+  int backing_fd = open_read_only_fs_file(superblock->backing_path);
+  if (backing_fd == -1) {
+    fprintf(stderr, "Can't open backing image %s\n", superblock->backing_path);
+    return false;
+  }
+
+  struct superblock* backing =
+      (struct superblock*) arena_calloc(1, sizeof(struct superblock));
+  if (read_super_block_record(backing_fd, backing) == -1) {
+    close(backing_fd);
+    return false;
+  }
+
+  const struct fs_info* fs_info = superblock->fs_info;
+  if (backing->fs_info->magic != MAGIC
+      || backing->fs_info->inodes_count != fs_info->inodes_count
+      || backing->fs_info->blocks_count != fs_info->blocks_count
+      || backing->fs_info->block_size != fs_info->block_size
+      || backing->fs_info->blocks_count_in_inode
+          != fs_info->blocks_count_in_inode
+      || backing->fs_info->max_path_len != fs_info->max_path_len) {
+    fprintf(stderr, "Backing image doesn't match overlay!\n");
+    close(backing_fd);
+    return false;
+  }
+
+  superblock->backing = backing;
+  superblock->backing_fd = backing_fd;
+  return true;
+}
+
+ssize_t read_super_block_record(const int fd, struct superblock* superblock) {
+  size_t default_size = DEFAULT_SUPERBLOCK_SIZE;
+  superblock->backing = NULL;
+  superblock->backing_fd = -1;
+  superblock->record = (char*) arena_calloc(default_size, sizeof(char));
 
-  if (total_read == -1) {
+  if (pread_while(fd, superblock->record, default_size, 0) == -1) {
     fprintf(stderr, "%s", strerror(errno));
-    free(superblock->fs_info);
+    destroy_super_block(superblock);
     return -1;
   }
 
-  init_superblock_arrays(superblock);
-  ssize_t readed = read_while(fd,
-                              (char*) superblock->reserved_inodes_mask,
-                              superblock->fs_info->inodes_count);
-  if (readed == -1) {
-    fprintf(stderr, "%s", strerror(errno));
+  init_superblock_views(superblock);
+
+  if (superblock->fs_info->inodes_count == 0
+      || superblock->fs_info->blocks_count == 0
+      || superblock->fs_info->initialized_inodes
+          > superblock->fs_info->inodes_count
+      || superblock->fs_info->blocks_count_in_inode > BLOCKS_COUNT_IN_INODE
+      || (superblock->fs_info->block_size
+          & (superblock->fs_info->block_size - 1)) != 0
+      || superblock->fs_info->block_size
+          < 2 * (sizeof(uint16_t) + superblock->fs_info->max_path_len)
+      || ((superblock->fs_info->flags & FS_FLAG_ALIGNED)
+          && superblock->fs_info->block_size % IMAGE_ALIGNMENT != 0)) {
+    fprintf(stderr, "Unsupported geometry!\n");
     destroy_super_block(superblock);
     return -1;
   }
 
-  total_read += readed;
+  size_t size = sizeof_superblock(superblock);
+  if (size > default_size) {
+    char* record = (char*) arena_calloc(size, sizeof(char));
+    memcpy(record, superblock->record, default_size);
 
-  readed = read_while(fd,
-                      (char*) superblock->reserved_blocks_mask,
-                      superblock->fs_info->blocks_count);
-  if (readed == -1) {
-    fprintf(stderr, "%s", strerror(errno));
+    if (pread_while(fd,
+                    record + default_size,
+                    size - default_size,
+                    default_size) == -1) {
+      fprintf(stderr, "%s", strerror(errno));
+      destroy_super_block(superblock);
+      return -1;
+    }
+
+    superblock->record = record;
+    init_superblock_views(superblock);
+  }
+
+  if (!is_record_checksum_valid(superblock->record, size)) {
+    fprintf(stderr, "Superblock checksum mismatch!\n");
     destroy_super_block(superblock);
     return -1;
   }
 
-  total_read += readed;
+  init_layout(superblock);
+  init_fingerprint_buckets(superblock);
+  size_t block_table_size =
+      superblock->fs_info->blocks_count * sizeof(struct block_info);
+  superblock->block_table = (char*) arena_calloc(block_table_size, sizeof(char));
+  if (pread_while(fd,
+                  superblock->block_table,
+                  block_table_size,
+                  get_block_info_offset(superblock, 0)) == -1) {
+    fprintf(stderr, "%s", strerror(errno));
+    destroy_super_block(superblock);
+    return -1;
+  }
 
-  return total_read;
+  if (!open_backing_image(superblock)) {
+    destroy_super_block(superblock);
+    return -1;
+  }
+  return size;
 }
 
-ssize_t write_super_block(const int fd, struct superblock* superblock) {
-  lseek(fd, 0, SEEK_SET);
-  ssize_t total_written = write_while(fd,
-                                      (const char*) superblock->fs_info,
-                                      sizeof(struct fs_info));
+ssize_t read_super_block(const int fd, struct superblock* superblock) {
+  ssize_t size = read_super_block_record(fd, superblock);
+  if (size == -1) {
+    return -1;
+  }
 
-  if (total_written == -1) {
-    fprintf(stderr, "%s", strerror(errno));
+  if (!load_mounted_snapshot(fd, superblock)) {
+    destroy_super_block(superblock);
     return -1;
   }
+  return size;
+}
 
-  ssize_t written = write_while(fd,
-                                (const char*) superblock->reserved_inodes_mask,
-                                superblock->fs_info->inodes_count);
-  if (written == -1) {
-    fprintf(stderr, "%s\n", strerror(errno));
+ssize_t write_super_block(const int fd, const struct superblock* superblock) {
+  if (superblock->snapshot_inodes != NULL) {
+    fprintf(stderr, "Snapshot is read-only!\n");
     return -1;
   }
-  total_written += written;
 
-  written = write_while(fd,
-                        (const char*) superblock->reserved_blocks_mask,
-                        superblock->fs_info->blocks_count);
-  if (written == -1) {
+  set_record_checksum(superblock->record, sizeof_superblock(superblock));
+  ssize_t total_written = pwrite_while(fd,
+                                       superblock->record,
+                                       sizeof_superblock(superblock),
+                                       0);
+
+  if (total_written == -1) {
     fprintf(stderr, "%s\n", strerror(errno));
     return -1;
   }
-  total_written += written;
 
   return total_written;
 }
@@ -118,6 +271,9 @@ uint16_t reserve_inode(const struct superblock* superblock) {
   for (uint16_t id = 0; id < superblock->fs_info->inodes_count; ++id) {
     if (!superblock->reserved_inodes_mask[id]) {
       superblock->reserved_inodes_mask[id] = true;
+      if (id >= superblock->fs_info->initialized_inodes) {
+        superblock->fs_info->initialized_inodes = id + 1;
+      }
       return id;
     }
   }
@@ -129,6 +285,7 @@ uint16_t free_inode(const struct superblock* superblock,
                     const uint16_t inode_id) {
   if (superblock->reserved_inodes_mask[inode_id]) {
     superblock->reserved_inodes_mask[inode_id] = false;
+    superblock->orphan_inodes_mask[inode_id] = false;
     return inode_id;
   }
 
@@ -146,11 +303,207 @@ uint16_t reserve_block(const struct superblock* superblock) {
   return superblock->fs_info->blocks_count;
 }
 
+uint16_t find_free_blocks_run(const struct superblock* superblock,
+                              uint16_t from,
+                              uint16_t count) {
+  uint16_t run_length = 0;
+  for (uint16_t id = from; id < superblock->fs_info->blocks_count; ++id) {
+    run_length = superblock->reserved_blocks_mask[id] ? 0 : run_length + 1;
+    if (run_length == count) {
+      return id + 1 - count;
+    }
+  }
+
+  return superblock->fs_info->blocks_count;
+}
+
+uint16_t reserve_blocks(const struct superblock* superblock,
+                        uint16_t goal,
+                        uint16_t count,
+                        uint16_t* block_ids) {
+  uint16_t blocks_count = superblock->fs_info->blocks_count;
+  if (count == 0) {
+    return 0;
+  }
+
+  if (goal >= blocks_count) {
+    goal = 0;
+  }
+
+  uint16_t run_start = find_free_blocks_run(superblock, goal, count);
+  if (run_start == blocks_count && goal != 0) {
+    run_start = find_free_blocks_run(superblock, 0, count);
+  }
+
+  if (run_start != blocks_count) {
+    for (uint16_t i = 0; i < count; ++i) {
+      superblock->reserved_blocks_mask[run_start + i] = true;
+      block_ids[i] = run_start + i;
+    }
+    return count;
+  }
+
+  uint16_t reserved = 0;
+  for (uint16_t i = 0; i < blocks_count && reserved < count; ++i) {
+    uint16_t id = (goal + i) % blocks_count;
+    if (!superblock->reserved_blocks_mask[id]) {
+      superblock->reserved_blocks_mask[id] = true;
+      block_ids[reserved++] = id;
+    }
+  }
+
+  return reserved;
+}
+
+uint16_t get_cluster_size(const struct superblock* superblock) {
+  return (superblock->fs_info->flags & FS_FLAG_BIGALLOC) ? CLUSTER_SIZE : 1;
+}
+
+uint16_t find_free_cluster(const struct superblock* superblock,
+                           uint16_t from,
+                           uint16_t cluster_size) {
+  uint16_t blocks_count = superblock->fs_info->blocks_count;
+  for (uint32_t id = (from + cluster_size - 1) / cluster_size * cluster_size;
+       id + cluster_size <= blocks_count;
+       id += cluster_size) {
+    uint16_t index = 0;
+    while (index < cluster_size
+        && !superblock->reserved_blocks_mask[id + index]) {
+      ++index;
+    }
+
+    if (index == cluster_size) {
+      return id;
+    }
+  }
+
+  return blocks_count;
+}
+
+uint16_t reserve_cluster(const struct superblock* superblock, uint16_t goal) {
+  uint16_t blocks_count = superblock->fs_info->blocks_count;
+  uint16_t cluster_size = get_cluster_size(superblock);
+  if (goal >= blocks_count) {
+    goal = 0;
+  }
+
+  uint16_t first_block_id = find_free_cluster(superblock, goal, cluster_size);
+  if (first_block_id == blocks_count && goal != 0) {
+    first_block_id = find_free_cluster(superblock, 0, cluster_size);
+  }
+
+  if (first_block_id == blocks_count) {
+    return blocks_count;
+  }
+
+  for (uint16_t i = 0; i < cluster_size; ++i) {
+    superblock->reserved_blocks_mask[first_block_id + i] = true;
+  }
+  return first_block_id;
+}
+
 uint16_t free_block(const struct superblock* superblock, uint16_t block_id) {
   if (superblock->reserved_blocks_mask[block_id]) {
     superblock->reserved_blocks_mask[block_id] = false;
+    superblock->unwritten_blocks_mask[block_id] = false;
+    superblock->block_references[block_id] = 0;
+    if (superblock->block_fingerprints != NULL) {
+      set_block_fingerprint(superblock, block_id, 0);
+    }
     return block_id;
   }
 
   return superblock->fs_info->blocks_count;
+}
+
+bool release_block(const struct superblock* superblock, uint16_t block_id) {
+  if (superblock->block_references[block_id] > 0) {
+    superblock->block_references[block_id] -= 1;
+    return false;
+  }
+
+  free_block(superblock, block_id);
+  return true;
+}
+
+bool is_shared_block(const struct superblock* superblock, uint16_t block_id) {
+  return superblock->block_references[block_id] > 0;
+}
+
+uint32_t get_block_fingerprint(const struct superblock* superblock,
+                               uint16_t block_id) {
+  uint32_t fingerprint;
+  memcpy(&fingerprint,
+         superblock->block_fingerprints + block_id * sizeof(uint32_t),
+         sizeof(uint32_t));
+  return fingerprint;
+}
+
+static uint16_t* get_bucket_link(const struct superblock* superblock,
+                                 uint16_t block_id) {
+  uint16_t* link = &superblock->fingerprint_buckets[
+      get_block_fingerprint(superblock, block_id)
+          % superblock->fs_info->blocks_count];
+  while (*link != block_id) {
+    link = &superblock->fingerprint_chains[*link];
+  }
+  return link;
+}
+
+void set_block_fingerprint(const struct superblock* superblock,
+                           uint16_t block_id,
+                           uint32_t fingerprint) {
+  if (get_block_fingerprint(superblock, block_id) != 0) {
+    uint16_t* link = get_bucket_link(superblock, block_id);
+    *link = superblock->fingerprint_chains[block_id];
+  }
+
+  memcpy(superblock->block_fingerprints + block_id * sizeof(uint32_t),
+         &fingerprint,
+         sizeof(uint32_t));
+
+  if (fingerprint != 0) {
+    uint16_t* bucket = &superblock->fingerprint_buckets[
+        fingerprint % superblock->fs_info->blocks_count];
+    superblock->fingerprint_chains[block_id] = *bucket;
+    *bucket = block_id;
+  }
+}
+
+void init_fingerprint_buckets(struct superblock* superblock) {
+  superblock->fingerprint_buckets = NULL;
+  superblock->fingerprint_chains = NULL;
+  if (superblock->block_fingerprints == NULL) {
+    return;
+  }
+
+  uint16_t blocks_count = superblock->fs_info->blocks_count;
+  superblock->fingerprint_buckets =
+      (uint16_t*) arena_calloc(blocks_count, sizeof(uint16_t));
+  superblock->fingerprint_chains =
+      (uint16_t*) arena_calloc(blocks_count, sizeof(uint16_t));
+  for (uint16_t block_id = 0; block_id < blocks_count; ++block_id) {
+    superblock->fingerprint_buckets[block_id] = blocks_count;
+  }
+
+  for (uint16_t block_id = blocks_count; block_id > 0; --block_id) {
+    uint32_t fingerprint = get_block_fingerprint(superblock, block_id - 1);
+    if (fingerprint != 0) {
+      uint16_t* bucket =
+          &superblock->fingerprint_buckets[fingerprint % blocks_count];
+      superblock->fingerprint_chains[block_id - 1] = *bucket;
+      *bucket = block_id - 1;
+    }
+  }
+}
+
+uint16_t get_fingerprint_bucket(const struct superblock* superblock,
+                                uint32_t fingerprint) {
+  return superblock->fingerprint_buckets[
+      fingerprint % superblock->fs_info->blocks_count];
+}
+
+uint16_t get_next_in_bucket(const struct superblock* superblock,
+                            uint16_t block_id) {
+  return superblock->fingerprint_chains[block_id];
 }
\ No newline at end of file
@@ -9,11 +9,55 @@
 
 #include <stdint.h>
 #include <stdbool.h>
+#include <stddef.h>
+#include <unistd.h>
+#include "defines.h"
+
+/**
+ * @brief Regions and blocks of image are aligned to IMAGE_ALIGNMENT
+ */
+#define FS_FLAG_ALIGNED 1
+
+/**
+ * @brief Files are compressed when they are closed, see compress_inode_data()
+ */
+#define FS_FLAG_COMPRESSED 2
+
+/**
+ * @brief Identical data blocks are shared, see find_duplicate_block()
+ * Superblock of such image also stores fingerprints of data blocks
+ */
+#define FS_FLAG_DEDUP 4
+
+/**
+ * @brief Image is overlay of read-only backing image
+ * Superblock of such image also stores path to backing image.
+ * Inodes and blocks which were never written to overlay are zeros in it
+ * (image is sparse) and are read from backing image
+ */
+#define FS_FLAG_OVERLAY 8
+
+/**
+ * @brief Large files are allocated by clusters of CLUSTER_SIZE blocks
+ * Cluster is aligned run of blocks, see reserve_cluster() and
+ * INODE_FLAG_CLUSTERS. Small files and directories still use single blocks
+ */
+#define FS_FLAG_BIGALLOC 16
+
+/**
+ * @brief Last partial blocks of files are packed together in tail blocks
+ * when files are closed, see pack_tail_data()
+ */
+#define FS_FLAG_TAILPACK 32
 
 /**
  * @brief Contains main information about FS
+ * Inodes with id >= initialized_inodes were never used: they aren't read
+ * from image (image is sparse, so they are zeros there too).
+ * checksum is CRC32C of the rest of superblock record
  */
 struct __attribute__((__packed__)) fs_info {
+  uint32_t checksum;
   uint16_t inodes_count;
   uint16_t blocks_count;
   uint16_t block_size;
@@ -21,16 +65,81 @@ struct __attribute__((__packed__)) fs_info {
   uint16_t max_path_len;
   uint16_t descriptors_count;
   uint16_t magic;
+  uint16_t flags;
+  uint16_t initialized_inodes;
+};
+
+/**
+ * @brief Named read-only copy of namespace, see core/snapshot.h
+ * Snapshot is stored in blocks_count blocks starting from first_block_id.
+ * Free slot has zero blocks_count
+ */
+struct __attribute__((__packed__)) snapshot_info {
+  char name[MAX_PATH_LEN];
+  uint16_t first_block_id;
+  uint16_t blocks_count;
+};
+
+/**
+ * @brief Sizes and offsets of FS regions
+ * Computed once when superblock is read or inited, see core/layout.h
+ */
+struct layout {
+  size_t descriptors_table_offset;
+  size_t inodes_offset;
+  size_t block_table_offset;
+  size_t blocks_offset;
+  size_t inode_size;
+  uint32_t max_data_in_block;
+  uint8_t block_shift;
+  uint8_t max_records_count;
+  bool is_default;
 };
 
 /**
  * @brief Main suberblock struct
- * Contains fs_info and masks for blocks and inodes
+ * Contains fs_info and masks for blocks and inodes.
+ * Unwritten block is reserved (preallocated) but has no data yet:
+ * it is read as zeros and isn't read from image.
+ * Orphan inode is deleted but still reserved: it and its blocks
+ * are released later by reclaim_orphans().
+ * block_references is count of additional inode references of block,
+ * shared block is copied before it is changed (see release_block()).
+ * block_fingerprints is CRC32C of data of every data block, it is stored
+ * only with FS_FLAG_DEDUP and is NULL otherwise.
+ * fingerprint_buckets and fingerprint_chains are in-memory hash table over
+ * block_fingerprints: bucket is first block of chain, chain is next block
+ * with fingerprint in the same bucket (blocks_count ends both). They are built
+ * when superblock is read and are kept by set_block_fingerprint().
+ * record is on-disk superblock (fs_info, inodes mask, blocks mask,
+ * unwritten blocks mask, orphan inodes mask, block references, snapshots,
+ * block fingerprints, backing path),
+ * masks and fs_info are views into it, so superblock is read and written at once.
+ * snapshot_inodes isn't NULL when snapshot is mounted: inodes are read from it
+ * and nothing can be written.
+ * backing is superblock of backing image of overlay (NULL for other images),
+ * backing_fd is its read-only fd.
+ * block_table is on-disk table of block_info of every block. It is read with
+ * superblock, its entries are written by write_block()
  */
-struct __attribute__((__packed__)) superblock {
+struct superblock {
   struct fs_info* fs_info;
   bool* reserved_inodes_mask;
   bool* reserved_blocks_mask;
+  bool* unwritten_blocks_mask;
+  bool* orphan_inodes_mask;
+  uint8_t* block_references;
+  struct snapshot_info* snapshots;
+  char* block_fingerprints;
+  uint16_t* fingerprint_buckets;
+  uint16_t* fingerprint_chains;
+  char* record;
+  char* snapshot_inodes;
+  char* block_table;
+  char* backing_path;
+  struct superblock* backing;
+  int backing_fd;
+  struct layout layout;
 };
 
 /**
@@ -40,22 +149,45 @@ struct __attribute__((__packed__)) superblock {
  */
 size_t sizeof_superblock(const struct superblock* superblock);
 
+/**
+ * @brief Count size of on-disk superblock for geometry
+ * @param inodes_count
+ * @param blocks_count
+ * @param flags FS_FLAG_* flags of image
+ * @return size of superblock record in bytes
+ */
+size_t get_superblock_record_size(uint16_t inodes_count,
+                                  uint16_t blocks_count,
+                                  uint16_t flags);
+
 /**
  * @brief Constructor of superblock
  *
  * Construct superblock with default params defined in core/defines.h
  * @param superblock
+ * @param flags FS_FLAG_* flags of image. Aligned image uses ALIGNED_BLOCK_SIZE
+ * @param inodes_count
+ * @param blocks_count
  */
-void init_super_block(struct superblock* superblock);
+void init_super_block(struct superblock* superblock,
+                      uint16_t flags,
+                      uint16_t inodes_count,
+                      uint16_t blocks_count);
 
 /**
  * @brief Destructor of superblock
+ * Superblock is the first struct of every operation and the last one to be
+ * destroyed, so it resets arena: all core structs of operation are released.
+ * Backing images of overlay are closed
  * @param superblock
  */
 void destroy_super_block(struct superblock* superblock);
 
 /**
  * @brief Read sb from memory
+ * Superblock of default geometry is read with one pread.
+ * Backing image of overlay is opened read-only and its superblock is read.
+ * Mounted snapshot (see mount_snapshot()) is loaded too
  * @param fd opened fd
  * @param superblock empty instance of superblock
  * @return sizeof(superblock) if reading is ok; -1 otherwise and destruct superblock object
@@ -70,7 +202,7 @@ ssize_t read_super_block(int fd, struct superblock* superblock);
  * @return sizeof(superblock) if writing is ok; -1 otherwise
  * @warning printf strerror(errno) to stderr
  */
-ssize_t write_super_block(int fd, struct superblock* superblock);
+ssize_t write_super_block(int fd, const struct superblock* superblock);
 
 /**
  * @brief Reserve free inode
@@ -94,6 +226,49 @@ uint16_t free_inode(const struct superblock* superblock, uint16_t inode_id);
  */
 uint16_t reserve_block(const struct superblock* superblock);
 
+/**
+ * @brief Find first run of free blocks
+ * @param superblock
+ * @param from id to start search from
+ * @param count length of run
+ * @return id of first block of run if found; superblock->fs_info->blocks_count otherwise
+ */
+uint16_t find_free_blocks_run(const struct superblock* superblock,
+                              uint16_t from,
+                              uint16_t count);
+
+/**
+ * @brief Reserve several blocks at once
+ * Blocks are taken from first free run of count blocks at or after goal
+ * (or anywhere if there is no such run). If there is no run at all,
+ * first free blocks starting from goal are taken
+ * @param superblock
+ * @param goal preferred id of first block
+ * @param count
+ * @param block_ids array with at least count elements for reserved ids
+ * @return count of reserved blocks
+ */
+uint16_t reserve_blocks(const struct superblock* superblock,
+                        uint16_t goal,
+                        uint16_t count,
+                        uint16_t* block_ids);
+
+/**
+ * @param superblock
+ * @return count of blocks in cluster: CLUSTER_SIZE with FS_FLAG_BIGALLOC, 1 otherwise
+ */
+uint16_t get_cluster_size(const struct superblock* superblock);
+
+/**
+ * @brief Reserve free cluster
+ * Cluster is first free run of get_cluster_size() blocks aligned to
+ * cluster size at or after goal (or anywhere if there is no such run)
+ * @param superblock
+ * @param goal preferred id of first block
+ * @return id of first block of cluster if all ok; superblock->fs_info->blocks_count if there is no free cluster
+ */
+uint16_t reserve_cluster(const struct superblock* superblock, uint16_t goal);
+
 /**
  * @brief Release block
  * @param superblock
@@ -102,4 +277,61 @@ uint16_t reserve_block(const struct superblock* superblock);
  */
 uint16_t free_block(const struct superblock* superblock, uint16_t block_id);
 
+/**
+ * @brief Drop one reference of block
+ * Shared block loses one reference, not shared block is freed
+ * @param superblock
+ * @param block_id
+ * @return true if block is freed; false if it is still referenced
+ */
+bool release_block(const struct superblock* superblock, uint16_t block_id);
+
+/**
+ * @param superblock
+ * @param block_id
+ * @return true if block is referenced by more than one inode
+ */
+bool is_shared_block(const struct superblock* superblock, uint16_t block_id);
+
+/**
+ * @param superblock superblock of FS_FLAG_DEDUP image
+ * @param block_id
+ * @return fingerprint of block data; 0 if it is unknown
+ */
+uint32_t get_block_fingerprint(const struct superblock* superblock,
+                               uint16_t block_id);
+
+/**
+ * @brief Set fingerprint of block and move block to bucket of it
+ * @param superblock superblock of FS_FLAG_DEDUP image
+ * @param block_id
+ * @param fingerprint 0 to forget fingerprint
+ */
+void set_block_fingerprint(const struct superblock* superblock,
+                           uint16_t block_id,
+                           uint32_t fingerprint);
+
+/**
+ * @brief Build fingerprint buckets from block_fingerprints
+ * Does nothing for image without FS_FLAG_DEDUP
+ * @param superblock
+ */
+void init_fingerprint_buckets(struct superblock* superblock);
+
+/**
+ * @param superblock superblock of FS_FLAG_DEDUP image
+ * @param fingerprint
+ * @return first block of bucket of fingerprint; blocks_count if it is empty
+ */
+uint16_t get_fingerprint_bucket(const struct superblock* superblock,
+                                uint32_t fingerprint);
+
+/**
+ * @param superblock superblock of FS_FLAG_DEDUP image
+ * @param block_id block in some bucket
+ * @return next block of the same bucket; blocks_count if it is last
+ */
+uint16_t get_next_in_bucket(const struct superblock* superblock,
+                            uint16_t block_id);
+
 #endif //EXT_FILESYSTEM_SUBERBLOCK_H_
\ No newline at end of file
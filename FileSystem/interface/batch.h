@@ -0,0 +1,423 @@
+/**
+ * @file batch.h
+ * @author yaishenka
+ * @date 19.10.2026
+ * @brief Contains binary batched protocol
+ *
+ * Batch is a stream of requests. Every request is batch_request header
+ * followed by payload_size bytes of payload. Stream ends with BATCH_END request.
+ * For every request (except BATCH_END) batch_response header followed by
+ * payload_size bytes of payload is written in the same order.
+ * Payload of request is at most BATCH_MAX_PAYLOAD_SIZE bytes: request with
+ * bigger payload (or payload which can't be allocated) is skipped and
+ * gets -1 status.
+ * All integers are in host byte order.
+ */
+#ifndef EXT_FILESYSTEM_INTERFACE_BATCH_H_
+#define EXT_FILESYSTEM_INTERFACE_BATCH_H_
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdint.h>
+#include "create_dir.h"
+#include "create_file.h"
+#include "open_file.h"
+#include "close_file.h"
+#include "write_to_file.h"
+#include "read_file.h"
+#include "lseek_pos.h"
+#include "fallocate_file.h"
+#include "remove.h"
+
+#define BATCH_END 0
+#define BATCH_MKDIR 1
+#define BATCH_TOUCH 2
+#define BATCH_OPEN 3
+#define BATCH_CLOSE 4
+#define BATCH_WRITE 5
+#define BATCH_READ 6
+#define BATCH_LSEEK 7
+#define BATCH_FALLOCATE 8
+#define BATCH_REMOVE 9
+
+#define BATCH_MAX_PAYLOAD_SIZE (64 * 1024 * 1024)
+
+/**
+ * @brief Header of request
+ *
+ * mkdir, touch, open: payload is path
+ * close: file_descriptor
+ * write: file_descriptor, payload is data. Consecutive writes to one
+ *        file_descriptor are executed as one write (while joined data
+ *        fits in BATCH_MAX_PAYLOAD_SIZE)
+ * read: file_descriptor, argument is size (at most BATCH_MAX_PAYLOAD_SIZE,
+ *       so readed data fits in payload of response)
+ * lseek: file_descriptor, argument is position,
+ *        payload is optional whence (one byte: LSEEK_SET, LSEEK_DATA, LSEEK_HOLE,
+ *        LSEEK_END)
+ * fallocate: file_descriptor, argument is size
+ * remove: argument is mode (REMOVE_FILE, REMOVE_DIR, REMOVE_RECURSIVE),
+ *         payload is path. Inodes are reclaimed after batch
+ */
+struct __attribute__((__packed__)) batch_request {
+  uint8_t operation;
+  uint16_t file_descriptor;
+  uint64_t argument;
+  uint32_t payload_size;
+};
+
+/**
+ * @brief Header of response
+ *
+ * status is result of method (-1 if operation failed).
+ * For lseek status is new position.
+ * Only read has payload: readed data
+ */
+struct __attribute__((__packed__)) batch_response {
+  int64_t status;
+  uint32_t payload_size;
+};
+
+/**
+ * @brief Write response to output
+ * @param output
+ * @param status
+ * @param payload may be NULL if payload_size == 0
+ * @param payload_size
+ * @return true if all ok; false otherwise
+ */
+bool write_batch_response(FILE* output,
+                          int64_t status,
+                          const char* payload,
+                          uint32_t payload_size) {
+  struct batch_response response;
+  response.status = status;
+  response.payload_size = payload_size;
+
+  if (fwrite(&response, sizeof(struct batch_response), 1, output) != 1) {
+    return false;
+  }
+
+  if (payload_size != 0
+      && fwrite(payload, sizeof(char), payload_size, output) != payload_size) {
+    return false;
+  }
+
+  return true;
+}
+
+/**
+ * @brief Read and drop payload of skipped request
+ * @param input
+ * @param payload_size
+ * @return true if all ok; false if stream is broken
+ */
+bool skip_batch_payload(FILE* input, uint32_t payload_size) {
+  char buffer[BUFSIZ];
+  while (payload_size != 0) {
+    size_t size = payload_size < sizeof(buffer) ? payload_size : sizeof(buffer);
+    if (fread(buffer, sizeof(char), size, input) != size) {
+      return false;
+    }
+    payload_size -= size;
+  }
+
+  return true;
+}
+
+/**
+ * @brief Read payload of request
+ * @param input
+ * @param request
+ * @param payload pointer to payload terminated with '\0',
+ *        it is NULL if payload is skipped
+ * @return true if all ok; false if stream is broken
+ */
+bool read_batch_payload(FILE* input,
+                        const struct batch_request* request,
+                        char** payload) {
+  *payload = NULL;
+  if (request->payload_size > BATCH_MAX_PAYLOAD_SIZE) {
+    fprintf(stderr, "Payload of request is too big. Skip!\n");
+    return skip_batch_payload(input, request->payload_size);
+  }
+
+  *payload = (char*) calloc((size_t) request->payload_size + 1, sizeof(char));
+  if (*payload == NULL) {
+    fprintf(stderr, "Can't allocate payload of request. Skip!\n");
+    return skip_batch_payload(input, request->payload_size);
+  }
+
+  if (fread(*payload, sizeof(char), request->payload_size, input)
+      != request->payload_size) {
+    free(*payload);
+    *payload = NULL;
+    return false;
+  }
+
+  return true;
+}
+
+/**
+ * @brief Execute one request
+ * @param path_to_fs_file
+ * @param request
+ * @param payload payload of request terminated with '\0'
+ * @param output
+ * @return true if response was written; false otherwise
+ */
+bool execute_batch_request(const char* path_to_fs_file,
+                           const struct batch_request* request,
+                           char* payload,
+                           FILE* output) {
+  switch (request->operation) {
+    case BATCH_MKDIR:
+      return write_batch_response(output,
+                                  create_dir(path_to_fs_file, payload),
+                                  NULL,
+                                  0);
+    case BATCH_TOUCH:
+      return write_batch_response(output,
+                                  create_file(path_to_fs_file, payload),
+                                  NULL,
+                                  0);
+    case BATCH_OPEN:
+      return write_batch_response(output,
+                                  open_file(path_to_fs_file, payload),
+                                  NULL,
+                                  0);
+    case BATCH_CLOSE:
+      return write_batch_response(output,
+                                  close_file(path_to_fs_file,
+                                             request->file_descriptor),
+                                  NULL,
+                                  0);
+    case BATCH_WRITE:
+      return write_batch_response(output,
+                                  write_to_file(path_to_fs_file,
+                                                request->file_descriptor,
+                                                payload,
+                                                request->payload_size),
+                                  NULL,
+                                  0);
+    case BATCH_READ: {
+      if (request->argument > BATCH_MAX_PAYLOAD_SIZE) {
+        fprintf(stderr, "Size of read is too big. Skip!\n");
+        return write_batch_response(output, -1, NULL, 0);
+      }
+
+      char* data = (char*) calloc(request->argument, sizeof(char));
+      if (data == NULL && request->argument != 0) {
+        fprintf(stderr, "Can't allocate buffer for read. Skip!\n");
+        return write_batch_response(output, -1, NULL, 0);
+      }
+
+      ssize_t total_read = read_file(path_to_fs_file,
+                                     request->file_descriptor,
+                                     data,
+                                     request->argument);
+      bool result = write_batch_response(output,
+                                         total_read,
+                                         data,
+                                         total_read == -1 ? 0 : total_read);
+      free(data);
+      return result;
+    }
+    case BATCH_LSEEK:
+      return write_batch_response(output,
+                                  lseek_pos(path_to_fs_file,
+                                            request->file_descriptor,
+                                            request->argument,
+                                            request->payload_size == 0
+                                            ? LSEEK_SET : payload[0]),
+                                  NULL,
+                                  0);
+    case BATCH_FALLOCATE:
+      return write_batch_response(output,
+                                  fallocate_file(path_to_fs_file,
+                                                 request->file_descriptor,
+                                                 request->argument),
+                                  NULL,
+                                  0);
+    case BATCH_REMOVE:
+      return write_batch_response(output,
+                                  remove_path(path_to_fs_file,
+                                              payload,
+                                              request->argument),
+                                  NULL,
+                                  0);
+    default:
+      fprintf(stderr, "Unsupported batch operation. Skip!\n");
+      return write_batch_response(output, -1, NULL, 0);
+  }
+}
+
+/**
+ * @brief Execute run of writes to one descriptor
+ * Payloads of consecutive BATCH_WRITE requests to the same descriptor are
+ * joined and written with one write_to_file(), so blocks for whole run are
+ * allocated at once. Every request gets its own response.
+ * Run ends early if joined payload can't be allocated or would be bigger
+ * than BATCH_MAX_PAYLOAD_SIZE: next request starts new run
+ * @param path_to_fs_file
+ * @param request first write request
+ * @param payload payload of first request (is freed here)
+ * @param input
+ * @param output
+ * @param next first request after run
+ * @return count of executed requests if all ok; -1 if stream is broken
+ */
+ssize_t execute_batch_writes(const char* path_to_fs_file,
+                             const struct batch_request* request,
+                             char* payload,
+                             FILE* input,
+                             FILE* output,
+                             struct batch_request* next) {
+  uint16_t file_descriptor = request->file_descriptor;
+  size_t data_size = request->payload_size;
+  size_t requests_count = 1;
+  uint32_t* sizes = (uint32_t*) calloc(1, sizeof(uint32_t));
+  if (sizes != NULL) {
+    sizes[0] = request->payload_size;
+  }
+
+  while (true) {
+    if (fread(next, sizeof(struct batch_request), 1, input) != 1) {
+      fprintf(stderr, "Batch ended without end request. Abort!\n");
+      free(payload);
+      free(sizes);
+      return -1;
+    }
+
+    if (sizes == NULL
+        || next->operation != BATCH_WRITE
+        || next->file_descriptor != file_descriptor
+        || next->payload_size > BATCH_MAX_PAYLOAD_SIZE - data_size) {
+      break;
+    }
+
+    uint32_t* new_sizes =
+        (uint32_t*) realloc(sizes, (requests_count + 1) * sizeof(uint32_t));
+    if (new_sizes == NULL) {
+      break;
+    }
+    sizes = new_sizes;
+
+    char* new_payload =
+        (char*) realloc(payload, data_size + next->payload_size + 1);
+    if (new_payload == NULL) {
+      break;
+    }
+    payload = new_payload;
+
+    if (fread(payload + data_size, sizeof(char), next->payload_size, input)
+        != next->payload_size) {
+      fprintf(stderr, "Can't read payload of request. Abort!\n");
+      free(payload);
+      free(sizes);
+      return -1;
+    }
+    sizes[requests_count++] = next->payload_size;
+    data_size += next->payload_size;
+  }
+
+  ssize_t written =
+      write_to_file(path_to_fs_file, file_descriptor, payload, data_size);
+  free(payload);
+
+  for (size_t i = 0; i < requests_count; ++i) {
+    ssize_t status = written;
+    if (written != -1 && requests_count != 1) {
+      status = written < sizes[i] ? written : sizes[i];
+      written -= status;
+    }
+
+    if (!write_batch_response(output, status, NULL, 0)) {
+      free(sizes);
+      return -1;
+    }
+  }
+
+  free(sizes);
+  return requests_count;
+}
+
+/**
+ * @brief Execute batch of requests
+ * Read requests from input till BATCH_END and write responses to output
+ * @param path_to_fs_file
+ * @param input
+ * @param output
+ * @return count of executed requests if all ok; -1 if stream is broken
+ */
+ssize_t batch(const char* path_to_fs_file, FILE* input, FILE* output) {
+  ssize_t executed = 0;
+
+  struct batch_request request;
+  bool has_request = false;
+
+  while (true) {
+    if (!has_request
+        && fread(&request, sizeof(struct batch_request), 1, input) != 1) {
+      fprintf(stderr, "Batch ended without end request. Abort!\n");
+      fflush(output);
+      return -1;
+    }
+    has_request = false;
+
+    if (request.operation == BATCH_END) {
+      break;
+    }
+
+    char* payload;
+    if (!read_batch_payload(input, &request, &payload)) {
+      fprintf(stderr, "Can't read payload of request. Abort!\n");
+      fflush(output);
+      return -1;
+    }
+
+    if (payload == NULL) {
+      if (!write_batch_response(output, -1, NULL, 0)) {
+        fprintf(stderr, "Can't write response. Abort!\n");
+        return -1;
+      }
+      ++executed;
+      continue;
+    }
+
+    if (request.operation == BATCH_WRITE) {
+      struct batch_request next;
+      ssize_t writes_count = execute_batch_writes(path_to_fs_file,
+                                                  &request,
+                                                  payload,
+                                                  input,
+                                                  output,
+                                                  &next);
+      if (writes_count == -1) {
+        fprintf(stderr, "Can't execute writes. Abort!\n");
+        fflush(output);
+        return -1;
+      }
+
+      executed += writes_count;
+      request = next;
+      has_request = true;
+      continue;
+    }
+
+    bool written =
+        execute_batch_request(path_to_fs_file, &request, payload, output);
+    free(payload);
+
+    if (!written) {
+      fprintf(stderr, "Can't write response. Abort!\n");
+      return -1;
+    }
+
+    ++executed;
+  }
+
+  fflush(output);
+  return executed;
+}
+
+#endif //EXT_FILESYSTEM_INTERFACE_BATCH_H_
@@ -8,6 +8,8 @@
 #define EXT_FILESYSTEM_INTERFACE_CLIENT_H_
 #include <unistd.h>
 #include <string.h>
+#include <inttypes.h>
+#include <time.h>
 #include "init.h"
 #include "ls.h"
 #include "create_dir.h"
@@ -17,11 +19,21 @@
 #include "write_to_file.h"
 #include "read_file.h"
 #include "lseek_pos.h"
+#include "fallocate_file.h"
+#include "remove.h"
+#include "reclaimer.h"
+#include "defrag.h"
+#include "fsck.h"
+#include "batch.h"
+#include "snapshot.h"
+#include "stat.h"
 #include "../utils.h"
+#include "../core/arena.h"
 
 #define HELP "help"
 #define LS "ls"
 #define INIT "init"
+#define OVERLAY "overlay"
 #define READ_FS "read_fs"
 #define MKDIR "mkdir"
 #define TOUCH "touch"
@@ -33,16 +45,61 @@
 #define READ "read"
 #define READ_TO "read_to"
 #define LSEEK "lseek"
+#define FALLOCATE "fallocate"
+#define RM "rm"
+#define RMDIR "rmdir"
+#define RECURSIVE "-r"
+#define SYNC "sync"
+#define DEFRAG "defrag"
+#define COMPACT "compact"
+#define FSCK "fsck"
+#define REPAIR "repair"
+#define BATCH "batch"
+#define ALIGNED "aligned"
+#define COMPRESSED "compressed"
+#define DEDUP "dedup"
+#define BIGALLOC "bigalloc"
+#define TAILPACK "tailpack"
+#define DATA "data"
+#define HOLE "hole"
+#define END "end"
+#define STAT "stat"
+#define SNAPSHOT "snapshot"
+#define SNAPSHOTS "snapshots"
+#define RM_SNAPSHOT "rm_snapshot"
+#define MOUNT "mount"
+#define UMOUNT "umount"
 
 #define command_buffer_lenght 256
 
+bool is_modifying_command(const char* command) {
+  const char* commands[] = {INIT, OVERLAY, MKDIR, TOUCH, OPEN, CLOSE, READ,
+                            READ_TO, LSEEK, WRITE, WRITE_FROM, FALLOCATE, RM,
+                            RMDIR, DEFRAG, COMPACT, FSCK, BATCH, SNAPSHOT,
+                            RM_SNAPSHOT};
+  for (size_t i = 0; i < sizeof(commands) / sizeof(commands[0]); ++i) {
+    if (strcmp(commands[i], command) == 0) {
+      return true;
+    }
+  }
+
+  return false;
+}
+
 void client(const char* path_to_fs_file) {
   char buffer[command_buffer_lenght];
+  struct reclaimer reclaimer;
+  start_reclaimer(&reclaimer, path_to_fs_file);
 
   while (true) {
     read_command_from_stdin(buffer, command_buffer_lenght);
     char command[command_buffer_lenght];
     char* first_arg_pos = parse_command(buffer, command);
+    if (is_snapshot_mounted() && is_modifying_command(command)) {
+      printf("Snapshot is read-only, umount it first\n");
+      continue;
+    }
+
     if (strcmp(HELP, command) == 0) {
       printf("You are working with minifs\n"
              "Authored by yaishenka\n"
@@ -51,7 +108,15 @@ void client(const char* path_to_fs_file) {
              "help -- print this text\n"
              "quit -- close program\n"
              "ls [path] -- list directory contents\n"
-             "init -- init file system\n"
+             "init [aligned] [compressed] [dedup] [bigalloc] [tailpack] "
+             "[blocks_count] [inodes_count] -- "
+             "init file system. Aligned image has 4KiB aligned regions and "
+             "blocks, compressed image compresses files on close, "
+             "dedup image shares identical data blocks, "
+             "bigalloc image allocates large files by clusters of blocks, "
+             "tailpack image packs last blocks of closed files together\n"
+             "overlay [path] -- init file system as overlay of image at path. "
+             "Image at path is only read and mustn't be changed later\n"
              "read_fs -- read fs_file and checks it\n"
              "mkdir [path] -- make directories\n"
              "touch [path] -- create files\n"
@@ -62,10 +127,69 @@ void client(const char* path_to_fs_file) {
              "read [fd] [size] -- read size bytes from FD\n"
              "read_to [fd] [path] [size] -- read file from fd.pos and write data to path. "
              "If size not specified file will be readed till end\n"
-             "lseek [fd] [pos] -- set fd.pos = pos\n");
+             "lseek [fd] [pos] [data|hole|end] -- set fd.pos = pos. "
+             "With data/hole set fd.pos to next data/hole after pos, "
+             "with end set fd.pos = size of file + pos\n"
+             "stat [path] -- print inode, type, size and modification time "
+             "of file or directory\n"
+             "fallocate [fd] [size] -- preallocate blocks for size bytes of file. "
+             "Size of file isn't changed\n"
+             "rm [-r] [path] -- remove file. With -r remove directory "
+             "with all its content\n"
+             "rmdir [path] -- remove empty directory\n"
+             "sync -- wait till blocks of removed files are released\n"
+             "defrag -- move blocks of every file to contiguous run "
+             "and print fragments count\n"
+             "compact -- pack used blocks to the beginning and truncate fs_file\n"
+             "fsck [repair] -- check consistency of FS. "
+             "With repair found problems are repaired\n"
+             "batch -- read binary batch of requests from stdin till end request\n"
+             "snapshot [name] -- take snapshot of FS\n"
+             "snapshots -- list snapshots\n"
+             "rm_snapshot [name] -- remove snapshot\n"
+             "mount [name] -- mount snapshot read-only, "
+             "files can't be opened there\n"
+             "umount -- mount current FS back\n");
     } else if (strcmp(INIT, command) == 0) {
       printf("Initializing fs\n");
-      init_fs(path_to_fs_file);
+      uint16_t flags = 0;
+      long counts[2] = {BLOCKS_COUNT, INODES_COUNT};
+      size_t counts_parsed = 0;
+      while (first_arg_pos != NULL && strlen(first_arg_pos) != 0) {
+        char arg[command_buffer_lenght];
+        first_arg_pos = parse_command(first_arg_pos, arg);
+        if (strcmp(ALIGNED, arg) == 0) {
+          flags |= FS_FLAG_ALIGNED;
+        } else if (strcmp(COMPRESSED, arg) == 0) {
+          flags |= FS_FLAG_COMPRESSED;
+        } else if (strcmp(DEDUP, arg) == 0) {
+          flags |= FS_FLAG_DEDUP;
+        } else if (strcmp(BIGALLOC, arg) == 0) {
+          flags |= FS_FLAG_BIGALLOC;
+        } else if (strcmp(TAILPACK, arg) == 0) {
+          flags |= FS_FLAG_TAILPACK;
+        } else if (counts_parsed < 2) {
+          counts[counts_parsed++] = strtol(arg, NULL, 10);
+        }
+      }
+
+      if (counts[0] <= 0 || counts[0] > UINT16_MAX
+          || counts[1] <= 0 || counts[1] > UINT16_MAX) {
+        printf("Counts must be in [1, %u]\n", UINT16_MAX);
+        continue;
+      }
+      init_fs(path_to_fs_file, flags, counts[1], counts[0]);
+    } else if (strcmp(OVERLAY, command) == 0) {
+      if (first_arg_pos == NULL || strlen(first_arg_pos) == 0) {
+        printf("Overlay requires path\n");
+        continue;
+      }
+
+      char path[command_buffer_lenght];
+      parse_command(first_arg_pos, path);
+      if (init_overlay(path_to_fs_file, path) != -1) {
+        printf("Overlay of %s created\n", path);
+      }
     } else if (strcmp(READ_FS, command) == 0) {
       printf("Reading fs\n");
       read_fs(path_to_fs_file);
@@ -78,7 +202,36 @@ void client(const char* path_to_fs_file) {
       char path[command_buffer_lenght];
       parse_command(first_arg_pos, path);
       ls(path_to_fs_file, path);
+    } else if (strcmp(STAT, command) == 0) {
+      if (first_arg_pos == NULL || strlen(first_arg_pos) == 0) {
+        printf("Stat requires path\n");
+        continue;
+      }
+
+      char path[command_buffer_lenght];
+      parse_command(first_arg_pos, path);
+      struct file_stat file_stat;
+      if (stat_file(path_to_fs_file, path, &file_stat) != -1) {
+        time_t modified_time = (time_t) file_stat.modified_time;
+        char time_text[command_buffer_lenght];
+        strftime(time_text,
+                 sizeof(time_text),
+                 "%Y-%m-%d %H:%M:%S",
+                 localtime(&modified_time));
+        printf("Inode: %u\n"
+               "Type: %s\n"
+               "Size: %" PRIu64 "\n"
+               "Blocks: %u\n"
+               "Modified: %s\n",
+               file_stat.inode_id,
+               file_stat.is_file ? "file" : "directory",
+               file_stat.size,
+               file_stat.blocks_count,
+               time_text);
+      }
     } else if (strcmp(QUIT, command) == 0) {
+      stop_reclaimer(&reclaimer);
+      release_arena();
       return;
     } else if (strcmp(MKDIR, command) == 0) {
       if (first_arg_pos == NULL || strlen(first_arg_pos) == 0) {
@@ -106,7 +259,10 @@ void client(const char* path_to_fs_file) {
 
       char path[command_buffer_lenght];
       parse_command(first_arg_pos, path);
-      open_file(path_to_fs_file, path);
+      int opened_fd = open_file(path_to_fs_file, path);
+      if (opened_fd != -1) {
+        printf("opened fd: %d\n", opened_fd);
+      }
     } else if (strcmp(CLOSE, command) == 0) {
       if (first_arg_pos == NULL || strlen(first_arg_pos) == 0) {
         printf("Open requires path\n");
@@ -135,8 +291,17 @@ void client(const char* path_to_fs_file) {
       char data[command_buffer_lenght];
       parse_command(second_arg_position, data);
 
-      write_to_file(path_to_fs_file, fd_to_write, data, strlen(data));
+      ssize_t written =
+          write_to_file(path_to_fs_file, fd_to_write, data, strlen(data));
+      if (written != -1) {
+        printf("Total written: %zd\n", written);
+      }
     } else if (strcmp(READ, command) == 0) {
+      if (first_arg_pos == NULL || strlen(first_arg_pos) == 0) {
+        printf("Read requires fd\n");
+        continue;
+      }
+
       char fd_to_read_text[command_buffer_lenght];
       char* second_arg_position = parse_command(first_arg_pos, fd_to_read_text);
       uint16_t fd_to_read = strtol(fd_to_read_text, NULL, 10);
@@ -148,13 +313,22 @@ void client(const char* path_to_fs_file) {
 
       char size_to_read_text[command_buffer_lenght];
       parse_command(second_arg_position, size_to_read_text);
-      uint32_t size = strtol(size_to_read_text, NULL, 10);
+      uint64_t size = strtoull(size_to_read_text, NULL, 10);
 
-      char data[command_buffer_lenght];
+      char* data =
+          size < SIZE_MAX ? (char*) calloc(size + 1, sizeof(char)) : NULL;
+      if (data == NULL) {
+        printf("Can't allocate buffer of %" PRIu64 " bytes\n", size);
+        continue;
+      }
 
-      read_file(path_to_fs_file, fd_to_read, data, size);
-      data[size] = '\0';
-      printf("Readed: %s\n", data);
+      ssize_t total_read = read_file(path_to_fs_file, fd_to_read, data, size);
+      if (total_read != -1) {
+        printf("Total readed: %zd\n", total_read);
+        data[total_read] = '\0';
+        printf("Readed: %s\n", data);
+      }
+      free(data);
     } else if (strcmp(WRITE_FROM, command) == 0) {
       if (first_arg_pos == NULL || strlen(first_arg_pos) == 0) {
         printf("Write from requires fd\n");
@@ -172,7 +346,11 @@ void client(const char* path_to_fs_file) {
       }
       char path[command_buffer_lenght];
       parse_command(second_arg_position, path);
-      write_to_file_from_file(path_to_fs_file, fd_to_write, path);
+      ssize_t written =
+          write_to_file_from_file(path_to_fs_file, fd_to_write, path);
+      if (written != -1) {
+        printf("Total written: %zd\n", written);
+      }
     } else if (strcmp(READ_TO, command) == 0) {
       if (first_arg_pos == NULL || strlen(first_arg_pos) == 0) {
         printf("Read to requires fd\n");
@@ -198,7 +376,7 @@ void client(const char* path_to_fs_file) {
 
       char size_text[command_buffer_lenght];
       parse_command(third_argument_pos, size_text);
-      uint32_t size = strtol(size_text, NULL, 10);
+      uint64_t size = strtoull(size_text, NULL, 10);
       read_file_to_file(path_to_fs_file, fd_to_write, path, size);
     } else if (strcmp(LSEEK, command) == 0) {
       if (first_arg_pos == NULL || strlen(first_arg_pos) == 0) {
@@ -215,10 +393,146 @@ void client(const char* path_to_fs_file) {
       }
 
       char pos_text[command_buffer_lenght];
-      parse_command(second_arg_position, pos_text);
-      uint32_t pos = strtol(pos_text, NULL, 10);
+      char* third_argument_pos = parse_command(second_arg_position, pos_text);
+      uint64_t pos = strtoull(pos_text, NULL, 10);
+
+      int whence = LSEEK_SET;
+      if (third_argument_pos != NULL && strlen(third_argument_pos) != 0) {
+        char whence_text[command_buffer_lenght];
+        parse_command(third_argument_pos, whence_text);
+        if (strcmp(DATA, whence_text) == 0) {
+          whence = LSEEK_DATA;
+        } else if (strcmp(HOLE, whence_text) == 0) {
+          whence = LSEEK_HOLE;
+        } else if (strcmp(END, whence_text) == 0) {
+          whence = LSEEK_END;
+        } else {
+          printf("Lseek supports only data, hole or end\n");
+          continue;
+        }
+      }
 
-      lseek_pos(path_to_fs_file, fd_to_seek, pos);
+      ssize_t new_pos = lseek_pos(path_to_fs_file, fd_to_seek, pos, whence);
+      if (whence != LSEEK_SET && new_pos != -1) {
+        printf("Position: %zd\n", new_pos);
+      }
+    } else if (strcmp(FALLOCATE, command) == 0) {
+      if (first_arg_pos == NULL || strlen(first_arg_pos) == 0) {
+        printf("Fallocate requires fd\n");
+        continue;
+      }
+      char fd_to_allocate_text[command_buffer_lenght];
+      char* second_arg_position =
+          parse_command(first_arg_pos, fd_to_allocate_text);
+      uint16_t fd_to_allocate = strtol(fd_to_allocate_text, NULL, 10);
+
+      if (second_arg_position == NULL || strlen(second_arg_position) == 0) {
+        printf("Fallocate requires size\n");
+        continue;
+      }
+
+      char size_text[command_buffer_lenght];
+      parse_command(second_arg_position, size_text);
+      uint64_t size = strtoull(size_text, NULL, 10);
+
+      ssize_t allocated = fallocate_file(path_to_fs_file, fd_to_allocate, size);
+      if (allocated != -1) {
+        printf("Preallocated blocks: %zd\n", allocated);
+      }
+    } else if (strcmp(RM, command) == 0) {
+      if (first_arg_pos == NULL || strlen(first_arg_pos) == 0) {
+        printf("Rm requires path\n");
+        continue;
+      }
+
+      char path[command_buffer_lenght];
+      char* second_arg_position = parse_command(first_arg_pos, path);
+      int mode = REMOVE_FILE;
+      if (strcmp(RECURSIVE, path) == 0) {
+        if (second_arg_position == NULL || strlen(second_arg_position) == 0) {
+          printf("Rm requires path\n");
+          continue;
+        }
+        parse_command(second_arg_position, path);
+        mode = REMOVE_RECURSIVE;
+      }
+
+      if (remove_path(path_to_fs_file, path, mode) != -1) {
+        wake_reclaimer(&reclaimer);
+      }
+    } else if (strcmp(RMDIR, command) == 0) {
+      if (first_arg_pos == NULL || strlen(first_arg_pos) == 0) {
+        printf("Rmdir requires path\n");
+        continue;
+      }
+
+      char path[command_buffer_lenght];
+      parse_command(first_arg_pos, path);
+      if (remove_path(path_to_fs_file, path, REMOVE_DIR) != -1) {
+        wake_reclaimer(&reclaimer);
+      }
+    } else if (strcmp(SYNC, command) == 0) {
+      wait_reclaimer(&reclaimer);
+    } else if (strcmp(DEFRAG, command) == 0) {
+      defrag(path_to_fs_file);
+    } else if (strcmp(COMPACT, command) == 0) {
+      ssize_t size = compact(path_to_fs_file);
+      if (size != -1) {
+        printf("Size of fs_file: %zd\n", size);
+      }
+    } else if (strcmp(FSCK, command) == 0) {
+      char mode[command_buffer_lenght] = "";
+      if (first_arg_pos != NULL) {
+        parse_command(first_arg_pos, mode);
+      }
+
+      bool repair = strcmp(REPAIR, mode) == 0;
+      ssize_t problems = fsck(path_to_fs_file, repair);
+      if (problems != -1) {
+        printf("Found problems: %zd\n", problems);
+      }
+      if (repair && problems > 0) {
+        wake_reclaimer(&reclaimer);
+      }
+    } else if (strcmp(BATCH, command) == 0) {
+      batch(path_to_fs_file, stdin, stdout);
+      wake_reclaimer(&reclaimer);
+    } else if (strcmp(SNAPSHOT, command) == 0) {
+      if (first_arg_pos == NULL || strlen(first_arg_pos) == 0) {
+        printf("Snapshot requires name\n");
+        continue;
+      }
+
+      char name[command_buffer_lenght];
+      parse_command(first_arg_pos, name);
+      ssize_t blocks_count = snapshot(path_to_fs_file, name);
+      if (blocks_count != -1) {
+        printf("Snapshot blocks: %zd\n", blocks_count);
+      }
+    } else if (strcmp(SNAPSHOTS, command) == 0) {
+      list_snapshots(path_to_fs_file);
+    } else if (strcmp(RM_SNAPSHOT, command) == 0) {
+      if (first_arg_pos == NULL || strlen(first_arg_pos) == 0) {
+        printf("Rm_snapshot requires name\n");
+        continue;
+      }
+
+      char name[command_buffer_lenght];
+      parse_command(first_arg_pos, name);
+      remove_snapshot(path_to_fs_file, name);
+    } else if (strcmp(MOUNT, command) == 0) {
+      if (first_arg_pos == NULL || strlen(first_arg_pos) == 0) {
+        printf("Mount requires name\n");
+        continue;
+      }
+
+      char name[command_buffer_lenght];
+      parse_command(first_arg_pos, name);
+      if (mount(path_to_fs_file, name) != -1) {
+        printf("Mounted %s\n", name);
+      }
+    } else if (strcmp(UMOUNT, command) == 0) {
+      mount(path_to_fs_file, NULL);
     } else {
       printf("Unsupported command\n");
     }
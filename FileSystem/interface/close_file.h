@@ -16,23 +16,27 @@
 #include "../core/descriptors_table.h"
 #include "../core/defines.h"
 #include "../core/methods.h"
+#include "../core/file.h"
 #include "../utils.h"
 
 /**
  * @brief Close file
+ * File is compressed if image has FS_FLAG_COMPRESSED,
+ * its tail is packed if image has FS_FLAG_TAILPACK
  * @param path_to_fs_file
- * @param path
+ * @param fd_to_close
+ * @return closed fd if all ok; -1 otherwise
  */
-void close_file(const char* path_to_fs_file, const int fd_to_close) {
-  int fd = open(path_to_fs_file, O_RDWR | O_CREAT, S_IRUSR | S_IWUSR);
+int close_file(const char* path_to_fs_file, const int fd_to_close) {
+  int fd = open_fs_file(path_to_fs_file, 0);
   if (fd == -1) {
     fprintf(stderr, "Can't open file. Abort!\n");
     exit(EXIT_FAILURE);
   }
 
   struct superblock superblock;
-  read_super_block(fd, &superblock);
-  if (superblock.fs_info->magic != MAGIC) {
+  if (read_super_block(fd, &superblock) == -1
+      || superblock.fs_info->magic != MAGIC) {
     fprintf(stderr, "Magic does not match. Abort!\n");
     destroy_super_block(&superblock);
     close(fd);
@@ -54,17 +58,36 @@ void close_file(const char* path_to_fs_file, const int fd_to_close) {
     exit(EXIT_FAILURE);
   }
 
-  free_descriptor(&descriptors_table, fd_to_close, &superblock);
+  uint16_t flags = superblock.fs_info->flags;
+  if ((flags & (FS_FLAG_COMPRESSED | FS_FLAG_TAILPACK))
+      && superblock.snapshot_inodes == NULL
+      && fd_to_close >= 0
+      && fd_to_close < superblock.fs_info->descriptors_count
+      && descriptors_table.reserved_fd[fd_to_close]) {
+    struct inode inode;
+    if (read_inode(fd,
+                   &inode,
+                   descriptors_table.fd_to_inode[fd_to_close],
+                   &superblock) == -1
+        || ((flags & FS_FLAG_COMPRESSED)
+            && compress_inode_data(fd, &inode, &superblock) == -1)
+        || ((flags & FS_FLAG_TAILPACK)
+            && pack_tail_data(fd, &inode, &superblock) == -1)
+        || write_super_block(fd, &superblock) == -1) {
+      fprintf(stderr, "Can't compress or pack file. Skip!\n");
+    }
+  }
+
+  int closed = free_descriptor(&descriptors_table, fd_to_close, &superblock);
   if (write_descriptor_table(fd, &descriptors_table, &superblock) == -1) {
     fprintf(stderr, "Can't write descriptors_table. Abort!\n");
-    destruct_descriptors_table(&descriptors_table, &superblock);
     destroy_super_block(&superblock);
     close(fd);
     exit(EXIT_FAILURE);
   }
 
-  destruct_descriptors_table(&descriptors_table, &superblock);
   destroy_super_block(&superblock);
   close(fd);
+  return closed;
 }
 #endif //EXT_FILESYSTEM_INTERFACE_CLOSE_FILE_H_
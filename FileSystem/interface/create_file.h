@@ -23,17 +23,18 @@
  * @brief Creates file
  * @param path_to_fs_file
  * @param path
+ * @return 0 if all ok; -1 otherwise
  */
-void create_file(const char* path_to_fs_file, const char* path) {
-  int fd = open(path_to_fs_file, O_RDWR | O_CREAT, S_IRUSR | S_IWUSR);
+int create_file(const char* path_to_fs_file, const char* path) {
+  int fd = open_fs_file(path_to_fs_file, 0);
   if (fd == -1) {
     fprintf(stderr, "Can't open file. Abort!\n");
     exit(EXIT_FAILURE);
   }
 
   struct superblock superblock;
-  read_super_block(fd, &superblock);
-  if (superblock.fs_info->magic != MAGIC) {
+  if (read_super_block(fd, &superblock) == -1
+      || superblock.fs_info->magic != MAGIC) {
     fprintf(stderr, "Magic does not match. Abort!\n");
     destroy_super_block(&superblock);
     close(fd);
@@ -54,7 +55,14 @@ void create_file(const char* path_to_fs_file, const char* path) {
     fprintf(stderr, "Incorrect path. Abort!\n");
     destroy_super_block(&superblock);
     close(fd);
-    return;
+    return -1;
+  }
+
+  if (strlen(dirname) >= superblock.fs_info->max_path_len) {
+    fprintf(stderr, "Name is too long. Abort!\n");
+    destroy_super_block(&superblock);
+    close(fd);
+    return -1;
   }
 
   uint16_t inode_id = get_inode_id_of_dir(fd, parent_path, &superblock);
@@ -62,7 +70,7 @@ void create_file(const char* path_to_fs_file, const char* path) {
     fprintf(stderr, "Can't find directory. Abort!\n");
     destroy_super_block(&superblock);
     close(fd);
-    return;
+    return -1;
   }
 
   struct inode inode;
@@ -70,70 +78,63 @@ void create_file(const char* path_to_fs_file, const char* path) {
     fprintf(stderr, "Can't read inode. Abort!\n");
     destroy_super_block(&superblock);
     close(fd);
+    return -1;
   }
 
   if (inode.inode_info->is_file) {
     fprintf(stderr, "Trying to mkdir in file. Abort!\n");
-    destroy_inode(&inode);
     destroy_super_block(&superblock);
     close(fd);
-    return;
+    return -1;
   }
 
   if (is_dir_exist(fd, &inode, dirname, &superblock)) {
     fprintf(stderr, "Dir already exist! Abort!\n");
-    destroy_inode(&inode);
-    destroy_super_block(&superblock);
-    close(fd);
-    return;
-  }
-
-  uint16_t new_inode_id = create_file_helper(fd, &superblock, inode_id);
-
-  if (new_inode_id == superblock.fs_info->inodes_count) {
-    fprintf(stderr, "Can't create more inodes! Abort!\n");
-    destroy_inode(&inode);
     destroy_super_block(&superblock);
     close(fd);
+    return -1;
   }
 
   struct block block;
   if (read_block(fd, &block, inode.block_ids[0], &superblock) == -1) {
     fprintf(stderr, "Can't read block. Abort!\n");
-    destroy_inode(&inode);
     destroy_super_block(&superblock);
     close(fd);
+    return -1;
   }
 
-  if (block.block_info->records_count == get_max_records_count(&superblock)) {
+  if (!can_add_block_record(&block, &superblock, dirname)) {
     fprintf(stderr, "Can't create more files in this dir. Abort!\n");
-    destroy_inode(&inode);
     destroy_super_block(&superblock);
     close(fd);
-    return;
+    return -1;
+  }
+
+  uint16_t new_inode_id = create_file_helper(fd, &superblock, inode_id);
+
+  if (new_inode_id == superblock.fs_info->inodes_count) {
+    fprintf(stderr, "Can't create more inodes! Abort!\n");
+    destroy_super_block(&superblock);
+    close(fd);
+    return -1;
   }
 
-  block.block_records = (struct block_record*) realloc(block.block_records,
-                                                       (block.block_info->records_count
-                                                           + 1)
-                                                           * sizeof(struct block_record));
-  struct block_record new_record;
-  init_block_record(&new_record, &superblock, new_inode_id);
-  strcpy(new_record.path, dirname);
-  block.block_records[block.block_info->records_count] = new_record;
-  block.block_info->records_count += 1;
-  if (write_block(fd, &block, &superblock) == -1) {
+  add_block_record(&block,
+                   &superblock,
+                   new_inode_id,
+                   RECORD_TYPE_FILE,
+                   dirname);
+  if (!write_directory_block(fd, &superblock, &inode, &block)) {
     fprintf(stderr, "Can't write block. Abort!\n");
-    destroy_inode(&inode);
-    destruct_block(&block);
+    discard_new_inode(fd, &superblock, new_inode_id);
     destroy_super_block(&superblock);
     close(fd);
+    return -1;
   }
 
-  destroy_inode(&inode);
-  destruct_block(&block);
   destroy_super_block(&superblock);
   close(fd);
+  return 0;
 }
 
 #endif //EXT_FILESYSTEM_INTERFACE_CREATE_FILE_H_
@@ -0,0 +1,181 @@
+/**
+ * @file defrag.h
+ * @author yaishenka
+ * @date 19.10.2026
+ * @brief Contains methods to defragment and compact FS
+ */
+#ifndef EXT_FILESYSTEM_INTERFACE_DEFRAG_H_
+#define EXT_FILESYSTEM_INTERFACE_DEFRAG_H_
+#include <stdlib.h>
+#include <unistd.h>
+#include <stdio.h>
+#include <errno.h>
+#include <string.h>
+#include <fcntl.h>
+#include "../core/superblock.h"
+#include "../core/defines.h"
+#include "../core/methods.h"
+#include "../core/defrag.h"
+#include "../core/layout.h"
+#include "../utils.h"
+
+/**
+ * @brief Defragment all files of directory recursively
+ * Prints fragments count of every file before and after
+ * @param fd opened fd
+ * @param superblock
+ * @param inode_id inode of directory
+ * @param path path of directory
+ * @return true if all ok; false otherwise
+ */
+bool defrag_dir(const int fd,
+                const struct superblock* superblock,
+                uint16_t inode_id,
+                const char* path) {
+  struct inode inode;
+  if (read_inode(fd, &inode, inode_id, superblock) == -1) {
+    fprintf(stderr, "Can't read inode. Abort!\n");
+    return false;
+  }
+
+  struct block block;
+  if (read_block(fd, &block, inode.block_ids[0], superblock) == -1) {
+    fprintf(stderr, "Can't read block. Abort!\n");
+    return false;
+  }
+
+  for (uint8_t record_id = 0; record_id < block.block_info->records_count;
+       ++record_id) {
+    const char* name = block.block_records[record_id].path;
+    char child_path[buffer_length];
+    snprintf(child_path, buffer_length, "%s/%s", path, name);
+
+    uint16_t child_id = block.block_records[record_id].inode_id;
+    if (block.block_records[record_id].type == RECORD_TYPE_DIR) {
+      if (!defrag_dir(fd, superblock, child_id, child_path)) {
+        return false;
+      }
+      continue;
+    }
+
+    struct inode child;
+    if (read_inode(fd, &child, child_id, superblock) == -1) {
+      fprintf(stderr, "Can't read inode. Abort!\n");
+      return false;
+    }
+
+    uint16_t fragments = count_fragments(&child, superblock);
+    ssize_t fragments_after = defrag_inode(fd, superblock, &child);
+    if (fragments_after == -1) {
+      return false;
+    }
+
+    printf("%s: %u -> %zd fragments\n", child_path, fragments, fragments_after);
+  }
+
+  return true;
+}
+
+/**
+ * @brief Defragment all files of FS
+ * Blocks of every fragmented file are moved to one contiguous run
+ * (if there is free run of such size)
+ * @param path_to_fs_file
+ * @return 0 if all ok; -1 otherwise
+ */
+int defrag(const char* path_to_fs_file) {
+  int fd = open_fs_file(path_to_fs_file, 0);
+  if (fd == -1) {
+    fprintf(stderr, "Can't open file. Abort!\n");
+    exit(EXIT_FAILURE);
+  }
+
+  struct superblock superblock;
+  if (read_super_block(fd, &superblock) == -1
+      || superblock.fs_info->magic != MAGIC) {
+    fprintf(stderr, "Magic does not match. Abort!\n");
+    destroy_super_block(&superblock);
+    close(fd);
+    exit(EXIT_FAILURE);
+  }
+
+  if (!superblock.reserved_inodes_mask[ROOT_INODE_ID]) {
+    fprintf(stderr, "Root directory doesn't exist. Abort!\n");
+    destroy_super_block(&superblock);
+    close(fd);
+    exit(EXIT_FAILURE);
+  }
+
+  bool result = defrag_dir(fd, &superblock, ROOT_INODE_ID, "");
+
+  if (write_super_block(fd, &superblock) == -1) {
+    fprintf(stderr, "Can't write superblock. Abort!\n");
+    destroy_super_block(&superblock);
+    close(fd);
+    exit(EXIT_FAILURE);
+  }
+
+  destroy_super_block(&superblock);
+  close(fd);
+  return result ? 0 : -1;
+}
+
+/**
+ * @brief Compact FS
+ * Packs used blocks to the beginning of blocks region and truncates
+ * image after last used block
+ * @param path_to_fs_file
+ * @return new size of image if all ok; -1 otherwise
+ */
+ssize_t compact(const char* path_to_fs_file) {
+  int fd = open_fs_file(path_to_fs_file, 0);
+  if (fd == -1) {
+    fprintf(stderr, "Can't open file. Abort!\n");
+    exit(EXIT_FAILURE);
+  }
+
+  struct superblock superblock;
+  if (read_super_block(fd, &superblock) == -1
+      || superblock.fs_info->magic != MAGIC) {
+    fprintf(stderr, "Magic does not match. Abort!\n");
+    destroy_super_block(&superblock);
+    close(fd);
+    exit(EXIT_FAILURE);
+  }
+
+  if (!superblock.reserved_inodes_mask[ROOT_INODE_ID]) {
+    fprintf(stderr, "Root directory doesn't exist. Abort!\n");
+    destroy_super_block(&superblock);
+    close(fd);
+    exit(EXIT_FAILURE);
+  }
+
+  ssize_t used_blocks = compact_blocks(fd, &superblock);
+
+  if (write_super_block(fd, &superblock) == -1) {
+    fprintf(stderr, "Can't write superblock. Abort!\n");
+    destroy_super_block(&superblock);
+    close(fd);
+    exit(EXIT_FAILURE);
+  }
+
+  if (used_blocks == -1) {
+    destroy_super_block(&superblock);
+    close(fd);
+    return -1;
+  }
+
+  ssize_t size = get_block_offset(&superblock, used_blocks);
+  if (ftruncate(fd, size) == -1) {
+    fprintf(stderr, "%s\n", strerror(errno));
+    destroy_super_block(&superblock);
+    close(fd);
+    return -1;
+  }
+
+  destroy_super_block(&superblock);
+  close(fd);
+  return size;
+}
+
+#endif //EXT_FILESYSTEM_INTERFACE_DEFRAG_H_
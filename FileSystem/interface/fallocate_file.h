@@ -0,0 +1,109 @@
+/**
+ * @file fallocate_file.h
+ * @author yaishenka
+ * @date 19.10.2026
+ * @brief Contains method to preallocate blocks of file
+ */
+#ifndef EXT_FILESYSTEM_INTERFACE_FALLOCATE_FILE_H_
+#define EXT_FILESYSTEM_INTERFACE_FALLOCATE_FILE_H_
+#include <stdlib.h>
+#include <unistd.h>
+#include <stdio.h>
+#include <errno.h>
+#include <string.h>
+#include <fcntl.h>
+#include "../core/superblock.h"
+#include "../core/descriptors_table.h"
+#include "../core/defines.h"
+#include "../core/file.h"
+#include "../utils.h"
+
+/**
+ * @brief Preallocate blocks of file
+ * Reserves contiguous (if possible) blocks for first size bytes of file.
+ * Blocks are unwritten: they are read as zeros, size of file isn't changed
+ * and writes to them don't allocate blocks
+ * @param path_to_fs_file
+ * @param file_descriptor opened file descriptor from our FS
+ * @param size
+ * @return count of reserved blocks if all ok; -1 otherwise
+ */
+ssize_t fallocate_file(const char* path_to_fs_file,
+                       uint16_t file_descriptor,
+                       uint64_t size) {
+  int fd = open_fs_file(path_to_fs_file, 0);
+  if (fd == -1) {
+    fprintf(stderr, "Can't open file. Abort!\n");
+    exit(EXIT_FAILURE);
+  }
+
+  struct superblock superblock;
+  if (read_super_block(fd, &superblock) == -1
+      || superblock.fs_info->magic != MAGIC) {
+    fprintf(stderr, "Magic does not match. Abort!\n");
+    destroy_super_block(&superblock);
+    close(fd);
+    exit(EXIT_FAILURE);
+  }
+
+  if (!superblock.reserved_inodes_mask[ROOT_INODE_ID]) {
+    fprintf(stderr, "Root directory doesn't exist. Abort!\n");
+    destroy_super_block(&superblock);
+    close(fd);
+    exit(EXIT_FAILURE);
+  }
+
+  if (size > get_max_data_size_of_all_blocks(&superblock)) {
+    fprintf(stderr, "Size > max_data_in_file. Abort!\n");
+    destroy_super_block(&superblock);
+    close(fd);
+    return -1;
+  }
+
+  struct descriptors_table descriptors_table;
+  if (read_descriptors_table(fd, &descriptors_table, &superblock) == -1) {
+    fprintf(stderr, "Can't read descriptors_table. Abort!\n");
+    destroy_super_block(&superblock);
+    close(fd);
+    exit(EXIT_FAILURE);
+  }
+
+  if (file_descriptor >= superblock.fs_info->descriptors_count
+      || !descriptors_table.reserved_fd[file_descriptor]) {
+    fprintf(stderr, "Descriptor is closed. Abort!\n");
+    destroy_super_block(&superblock);
+    close(fd);
+    return -1;
+  }
+
+  struct inode inode;
+  if (read_inode(fd,
+                 &inode,
+                 descriptors_table.fd_to_inode[file_descriptor],
+                 &superblock) == -1) {
+    fprintf(stderr, "Can't read inode. Abort!\n");
+    destroy_super_block(&superblock);
+    close(fd);
+    exit(EXIT_FAILURE);
+  }
+
+  ssize_t allocated = allocate_inode_data(fd, &inode, &superblock, size);
+  if (allocated == -1) {
+    destroy_super_block(&superblock);
+    close(fd);
+    return -1;
+  }
+
+  if (write_super_block(fd, &superblock) == -1) {
+    fprintf(stderr, "Can't write superblock. Abort!\n");
+    destroy_super_block(&superblock);
+    close(fd);
+    exit(EXIT_FAILURE);
+  }
+
+  destroy_super_block(&superblock);
+  close(fd);
+  return allocated;
+}
+
+#endif //EXT_FILESYSTEM_INTERFACE_FALLOCATE_FILE_H_
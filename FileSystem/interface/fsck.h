@@ -0,0 +1,89 @@
+/**
+ * @file fsck.h
+ * @author yaishenka
+ * @date 19.10.2026
+ * @brief Contains method to check consistency of FS
+ */
+#ifndef EXT_FILESYSTEM_INTERFACE_FSCK_H_
+#define EXT_FILESYSTEM_INTERFACE_FSCK_H_
+#include <stdlib.h>
+#include <unistd.h>
+#include <stdio.h>
+#include <errno.h>
+#include <string.h>
+#include <fcntl.h>
+#include "../core/superblock.h"
+#include "../core/defines.h"
+#include "../core/fsck.h"
+#include "../utils.h"
+
+/**
+ * @brief Check consistency of FS
+ * Inodes are checked by one worker thread per online CPU.
+ * Prints found problems
+ * @param path_to_fs_file
+ * @param repair repair found problems (see check_fs)
+ * @return count of found problems if all ok; -1 otherwise
+ */
+ssize_t fsck(const char* path_to_fs_file, bool repair) {
+  int fd = open_fs_file(path_to_fs_file, 0);
+  if (fd == -1) {
+    fprintf(stderr, "Can't open file. Abort!\n");
+    exit(EXIT_FAILURE);
+  }
+
+  struct superblock superblock;
+  if (read_super_block(fd, &superblock) == -1
+      || superblock.fs_info->magic != MAGIC) {
+    fprintf(stderr, "Magic does not match. Abort!\n");
+    destroy_super_block(&superblock);
+    close(fd);
+    return -1;
+  }
+
+  if (!superblock.reserved_inodes_mask[ROOT_INODE_ID]) {
+    fprintf(stderr, "Root directory doesn't exist. Abort!\n");
+    destroy_super_block(&superblock);
+    close(fd);
+    return -1;
+  }
+
+  long threads_count = sysconf(_SC_NPROCESSORS_ONLN);
+  if (threads_count < 1) {
+    threads_count = 1;
+  }
+
+  struct fsck_report report;
+  ssize_t problems =
+      check_fs(fd, &superblock, repair, threads_count, &report);
+  if (problems == -1) {
+    destroy_super_block(&superblock);
+    close(fd);
+    return -1;
+  }
+
+  printf("Checked inodes: %u\n", report.checked_inodes);
+  printf("Unreachable inodes: %u\n", report.unreachable_inodes);
+  printf("Multiply linked inodes: %u\n", report.multiply_linked_inodes);
+  printf("Bad directory records: %u\n", report.bad_records);
+  printf("Bad block ids: %u\n", report.bad_block_ids);
+  printf("Leaked blocks: %u\n", report.leaked_blocks);
+  printf("Unreserved blocks: %u\n", report.unreserved_blocks);
+  printf("Doubly allocated blocks: %u\n", report.doubly_allocated_blocks);
+  printf("Bad block references: %u\n", report.bad_references);
+  printf("Damaged records: %u\n", report.damaged_records);
+
+  if (repair && problems != 0
+      && write_super_block(fd, &superblock) == -1) {
+    fprintf(stderr, "Can't write superblock. Abort!\n");
+    destroy_super_block(&superblock);
+    close(fd);
+    exit(EXIT_FAILURE);
+  }
+
+  destroy_super_block(&superblock);
+  close(fd);
+  return problems;
+}
+
+#endif //EXT_FILESYSTEM_INTERFACE_FSCK_H_
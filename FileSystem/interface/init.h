@@ -13,56 +13,146 @@
 #include <errno.h>
 #include <string.h>
 #include <fcntl.h>
+#include <limits.h>
+#include <sys/stat.h>
 #include "../core/superblock.h"
 #include "../core/descriptors_table.h"
 #include "../core/defines.h"
 #include "../core/methods.h"
+#include "../core/layout.h"
+#include "../utils.h"
 
 /**
  * @brief Init filesystem
- * Trunc file and init our FS in it. Creates superblock, descriptor_table and root_dir
+ * Trunc file and init our FS in it. File is sized with one ftruncate and
+ * stays sparse: descriptors_table and inodes are zeros there and
+ * aren't written. Only superblock, root inode and root block are written
  * @param path_to_fs_file
+ * @param flags FS_FLAG_* flags of image
+ * @param inodes_count
+ * @param blocks_count
  */
-void init_fs(const char* path_to_fs_file) {
-  int fd = open(path_to_fs_file, O_RDWR | O_CREAT | O_TRUNC, S_IRUSR | S_IWUSR);
+void init_fs(const char* path_to_fs_file,
+             uint16_t flags,
+             uint16_t inodes_count,
+             uint16_t blocks_count) {
+  int fd = open_fs_file(path_to_fs_file, O_TRUNC);
   if (fd == -1) {
     fprintf(stderr, "Can't open file. Abort!");
     exit(EXIT_FAILURE);
   }
 
   struct superblock superblock;
-  init_super_block(&superblock);
-  if (write_super_block(fd, &superblock) == -1) {
+  init_super_block(&superblock, flags, inodes_count, blocks_count);
+  if (ftruncate(fd, get_block_offset(&superblock, blocks_count)) == -1) {
+    fprintf(stderr, "%s\n", strerror(errno));
     destroy_super_block(&superblock);
-    fprintf(stderr, "Can't write superblock. Abort!");
+    fprintf(stderr, "Can't resize fs_file. Abort!");
     exit(EXIT_FAILURE);
   }
 
-  struct descriptors_table descriptors_table;
-  init_descriptors_table(&descriptors_table, &superblock);
-  if (write_descriptor_table(fd, &descriptors_table, &superblock) == -1) {
-    fprintf(stderr, "Can't write descriptors_table. Abort!");
-    destruct_descriptors_table(&descriptors_table, &superblock);
-    destroy_super_block(&superblock);
-    exit(EXIT_FAILURE);
+  create_dir_helper(fd, &superblock, 0, true);
+
+  destroy_super_block(&superblock);
+  close(fd);
+}
+
+/**
+ * @brief Init overlay of backing image
+ * Trunc file and init overlay FS in it: superblock of backing image is copied
+ * and nothing else is written, so overlay is created at once and grows only
+ * with changes. Inodes and blocks which aren't changed in overlay are read
+ * from backing image, it is never written and mustn't be changed later
+ * @param path_to_fs_file
+ * @param path_to_backing_file
+ * @return 0 if all ok; -1 otherwise
+ */
+int init_overlay(const char* path_to_fs_file,
+                 const char* path_to_backing_file) {
+  char backing_path[PATH_MAX];
+  if (realpath(path_to_backing_file, backing_path) == NULL) {
+    fprintf(stderr, "%s\n", strerror(errno));
+    fprintf(stderr, "Can't find backing image. Abort!\n");
+    return -1;
   }
 
-  create_dir_helper(fd, &superblock, 0, true);
+  if (strlen(backing_path) >= BACKING_PATH_LEN) {
+    fprintf(stderr, "Path to backing image is too long. Abort!\n");
+    return -1;
+  }
+
+  int backing_fd = open_read_only_fs_file(backing_path);
+  if (backing_fd == -1) {
+    fprintf(stderr, "Can't open backing image. Abort!\n");
+    return -1;
+  }
+
+  struct stat backing_stat;
+  struct stat overlay_stat;
+  if (fstat(backing_fd, &backing_stat) == 0
+      && stat(path_to_fs_file, &overlay_stat) == 0
+      && backing_stat.st_dev == overlay_stat.st_dev
+      && backing_stat.st_ino == overlay_stat.st_ino) {
+    fprintf(stderr, "Image can't be overlay of itself. Abort!\n");
+    close(backing_fd);
+    return -1;
+  }
+
+  struct superblock backing;
+  if (read_super_block(backing_fd, &backing) == -1
+      || backing.fs_info->magic != MAGIC) {
+    fprintf(stderr, "Magic does not match. Abort!\n");
+    destroy_super_block(&backing);
+    close(backing_fd);
+    return -1;
+  }
+
+  int fd = open_fs_file(path_to_fs_file, O_TRUNC);
+  if (fd == -1) {
+    fprintf(stderr, "Can't open file. Abort!\n");
+    destroy_super_block(&backing);
+    close(backing_fd);
+    return -1;
+  }
+
+  uint16_t flags = backing.fs_info->flags | FS_FLAG_OVERLAY;
+  struct superblock superblock;
+  init_super_block(&superblock,
+                   flags,
+                   backing.fs_info->inodes_count,
+                   backing.fs_info->blocks_count);
+  memcpy(superblock.record,
+         backing.record,
+         sizeof_superblock(&superblock) - BACKING_PATH_LEN);
+  superblock.fs_info->flags = flags;
+  init_layout(&superblock);
+  strcpy(superblock.backing_path, backing_path);
+
+  int result = 0;
+  if (ftruncate(fd, get_block_offset(&superblock,
+                                     superblock.fs_info->blocks_count)) == -1
+      || write_super_block(fd, &superblock) == -1) {
+    fprintf(stderr, "%s\n", strerror(errno));
+    fprintf(stderr, "Can't init overlay. Abort!\n");
+    result = -1;
+  }
 
-  destruct_descriptors_table(&descriptors_table, &superblock);
+  destroy_super_block(&backing);
   destroy_super_block(&superblock);
+  close(backing_fd);
   close(fd);
+  return result;
 }
 
 void read_fs(const char* path_to_fs_file) {
-  int fd = open(path_to_fs_file, O_RDWR | O_CREAT, S_IRUSR | S_IWUSR);
+  int fd = open_fs_file(path_to_fs_file, 0);
   if (fd == -1) {
     fprintf(stderr, "Can't open file. Abort!");
     exit(EXIT_FAILURE);
   }
   struct superblock superblock;
-  read_super_block(fd, &superblock);
-  if (superblock.fs_info->magic != MAGIC) {
+  if (read_super_block(fd, &superblock) == -1
+      || superblock.fs_info->magic != MAGIC) {
     fprintf(stderr, "Magic does not match. Abort!");
     destroy_super_block(&superblock);
     close(fd);
@@ -19,20 +19,22 @@
 
 /**
  * @brief List directory
+ * "." and ".." are printed first: they aren't stored in directory block.
+ * Entries are classified by type of record, so inodes of entries aren't read
  * @param path_to_fs_file
  * @param path_to_dir
  * @warning Must be called only on initialized fs file
  */
 void ls(const char* path_to_fs_file, const char* path_to_dir) {
-  int fd = open(path_to_fs_file, O_RDWR | O_CREAT, S_IRUSR | S_IWUSR);
+  int fd = open_fs_file(path_to_fs_file, 0);
   if (fd == -1) {
     fprintf(stderr, "Can't open file. Abort!\n");
     exit(EXIT_FAILURE);
   }
 
   struct superblock superblock;
-  read_super_block(fd, &superblock);
-  if (superblock.fs_info->magic != MAGIC) {
+  if (read_super_block(fd, &superblock) == -1
+      || superblock.fs_info->magic != MAGIC) {
     fprintf(stderr, "Magic does not match. Abort!\n");
     destroy_super_block(&superblock);
     close(fd);
@@ -64,7 +66,6 @@ void ls(const char* path_to_fs_file, const char* path_to_dir) {
 
   if (inode.inode_info->is_file) {
     fprintf(stderr, "Trying to list file. Abort!\n");
-    destroy_inode(&inode);
     destroy_super_block(&superblock);
     close(fd);
     return;
@@ -73,37 +74,24 @@ void ls(const char* path_to_fs_file, const char* path_to_dir) {
   struct block block;
   if (read_block(fd, &block, inode.block_ids[0], &superblock) == -1) {
     fprintf(stderr, "Can't read block. Abort!\n");
-    destroy_inode(&inode);
     destroy_super_block(&superblock);
     close(fd);
     return;
   }
 
-  destroy_inode(&inode);
+  printf(".\n..\n");
   for (uint16_t record_id = 0; record_id < block.block_info->records_count;
        ++record_id) {
     printf("%s", block.block_records[record_id].path);
 
-    if (read_inode(fd,
-                   &inode,
-                   block.block_records[record_id].inode_id,
-                   &superblock) == -1) {
-      fprintf(stderr, "Can't read inode. Abort!\n");
-      destroy_super_block(&superblock);
-      close(fd);
-      return;
-    }
-
-    if (inode.inode_info->is_file) {
+    if (block.block_records[record_id].type == RECORD_TYPE_FILE) {
       printf(" -- file");
     }
 
-    destroy_inode(&inode);
 
     printf("\n");
   }
 
-  destruct_block(&block);
   destroy_super_block(&superblock);
   close(fd);
 }
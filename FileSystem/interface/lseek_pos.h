@@ -16,20 +16,34 @@
 #include "../core/descriptors_table.h"
 #include "../core/defines.h"
 #include "../core/methods.h"
+#include "../core/file.h"
 #include "../utils.h"
 
-void lseek_pos(const char* path_to_fs_file,
-               uint16_t file_descriptor,
-               uint32_t pos) {
-  int fd = open(path_to_fs_file, O_RDWR | O_CREAT, S_IRUSR | S_IWUSR);
+/**
+ * @brief Set position of FD
+ * LSEEK_SET sets position to pos.
+ * LSEEK_DATA/LSEEK_HOLE set position to next data/hole starting from pos
+ * (end of file is hole). LSEEK_END sets position to size of file + pos,
+ * size is stored in inode, so no blocks are read
+ * @param path_to_fs_file
+ * @param file_descriptor opened file descriptor from our FS
+ * @param pos
+ * @param whence LSEEK_SET, LSEEK_DATA, LSEEK_HOLE or LSEEK_END
+ * @return new position if all ok; -1 otherwise
+ */
+ssize_t lseek_pos(const char* path_to_fs_file,
+                  uint16_t file_descriptor,
+                  uint64_t pos,
+                  int whence) {
+  int fd = open_fs_file(path_to_fs_file, 0);
   if (fd == -1) {
     fprintf(stderr, "Can't open file. Abort!\n");
     exit(EXIT_FAILURE);
   }
 
   struct superblock superblock;
-  read_super_block(fd, &superblock);
-  if (superblock.fs_info->magic != MAGIC) {
+  if (read_super_block(fd, &superblock) == -1
+      || superblock.fs_info->magic != MAGIC) {
     fprintf(stderr, "Magic does not match. Abort!\n");
     destroy_super_block(&superblock);
     close(fd);
@@ -53,31 +67,52 @@ void lseek_pos(const char* path_to_fs_file,
 
   if (!descriptors_table.reserved_fd[file_descriptor]) {
     fprintf(stderr, "Descriptor is closed. Abort!\n");
-    destruct_descriptors_table(&descriptors_table, &superblock);
     destroy_super_block(&superblock);
-    return;
+    close(fd);
+    return -1;
   }
 
-  if (pos >= get_max_data_size_of_all_blocks(&superblock)) {
+  uint64_t new_pos = pos;
+  if (whence != LSEEK_SET) {
+    struct inode inode;
+    if (read_inode(fd,
+                   &inode,
+                   descriptors_table.fd_to_inode[file_descriptor],
+                   &superblock) == -1) {
+      fprintf(stderr, "Can't read inode. Abort!\n");
+      destroy_super_block(&superblock);
+      close(fd);
+      exit(EXIT_FAILURE);
+    }
+
+    ssize_t found = seek_inode_data(&inode, &superblock, pos, whence);
+    if (found == -1) {
+      destroy_super_block(&superblock);
+      close(fd);
+      return -1;
+    }
+    new_pos = found;
+  }
+
+  if (new_pos >= get_max_data_size_of_all_blocks(&superblock)) {
     fprintf(stderr, "Position >= max_data_in_file. Abort!\n");
-    destruct_descriptors_table(&descriptors_table, &superblock);
     destroy_super_block(&superblock);
-    return;
+    close(fd);
+    return -1;
   }
 
-  descriptors_table.fd_to_position[file_descriptor] = pos;
+  descriptors_table.fd_to_position[file_descriptor] = new_pos;
 
   if (write_descriptor_table(fd, &descriptors_table, &superblock) == -1) {
     fprintf(stderr, "Can't write descriptors_table. Abort!\n");
-    destruct_descriptors_table(&descriptors_table, &superblock);
     destroy_super_block(&superblock);
     close(fd);
     exit(EXIT_FAILURE);
   }
 
-  destruct_descriptors_table(&descriptors_table, &superblock);
   destroy_super_block(&superblock);
   close(fd);
+  return new_pos;
 }
 
 #endif //EXT_FILESYSTEM_INTERFACE_LSEEK_POS_H_
@@ -19,20 +19,21 @@
 #include "../utils.h"
 
 /**
- * @brief Open file and printf fd
+ * @brief Open file
  * @param path_to_fs_file
  * @param path
+ * @return opened fd if all ok; -1 otherwise
  */
-void open_file(const char* path_to_fs_file, const char* path) {
-  int fd = open(path_to_fs_file, O_RDWR | O_CREAT, S_IRUSR | S_IWUSR);
+int open_file(const char* path_to_fs_file, const char* path) {
+  int fd = open_fs_file(path_to_fs_file, 0);
   if (fd == -1) {
     fprintf(stderr, "Can't open file. Abort!\n");
     exit(EXIT_FAILURE);
   }
 
   struct superblock superblock;
-  read_super_block(fd, &superblock);
-  if (superblock.fs_info->magic != MAGIC) {
+  if (read_super_block(fd, &superblock) == -1
+      || superblock.fs_info->magic != MAGIC) {
     fprintf(stderr, "Magic does not match. Abort!\n");
     destroy_super_block(&superblock);
     close(fd);
@@ -53,7 +54,7 @@ void open_file(const char* path_to_fs_file, const char* path) {
     fprintf(stderr, "Incorrect path. Abort!\n");
     destroy_super_block(&superblock);
     close(fd);
-    return;
+    return -1;
   }
 
   uint16_t inode_id = get_inode_id_of_dir(fd, parent_path, &superblock);
@@ -61,7 +62,7 @@ void open_file(const char* path_to_fs_file, const char* path) {
     fprintf(stderr, "Can't find directory. Abort!\n");
     destroy_super_block(&superblock);
     close(fd);
-    return;
+    return -1;
   }
 
   struct inode inode;
@@ -69,20 +70,19 @@ void open_file(const char* path_to_fs_file, const char* path) {
     fprintf(stderr, "Can't read inode. Abort!\n");
     destroy_super_block(&superblock);
     close(fd);
+    return -1;
   }
 
   if (inode.inode_info->is_file) {
     fprintf(stderr, "File doesn't exist. Abort!\n");
-    destroy_inode(&inode);
     destroy_super_block(&superblock);
     close(fd);
-    return;
+    return -1;
   }
 
   struct descriptors_table descriptors_table;
   if (read_descriptors_table(fd, &descriptors_table, &superblock) == -1) {
     fprintf(stderr, "Can't read descriptors_table. Abort!\n");
-    destroy_inode(&inode);
     destroy_super_block(&superblock);
     close(fd);
     exit(EXIT_FAILURE);
@@ -92,11 +92,9 @@ void open_file(const char* path_to_fs_file, const char* path) {
 
   if (file_inode_id == superblock.fs_info->inodes_count) {
     fprintf(stderr, "File doesn't exist. Abort!\n");
-    destruct_descriptors_table(&descriptors_table, &superblock);
-    destroy_inode(&inode);
     destroy_super_block(&superblock);
     close(fd);
-    return;
+    return -1;
   }
 
   int new_fd =
@@ -104,27 +102,21 @@ void open_file(const char* path_to_fs_file, const char* path) {
 
   if (new_fd == -1) {
     fprintf(stderr, "Can't open file. Abort!\n");
-    destruct_descriptors_table(&descriptors_table, &superblock);
-    destroy_inode(&inode);
     destroy_super_block(&superblock);
     close(fd);
-    return;
+    return -1;
   }
 
   if (write_descriptor_table(fd, &descriptors_table, &superblock) == -1) {
     fprintf(stderr, "Can't write descriptors_table. Abort!\n");
-    destruct_descriptors_table(&descriptors_table, &superblock);
-    destroy_inode(&inode);
     destroy_super_block(&superblock);
     close(fd);
     exit(EXIT_FAILURE);
   }
 
-  printf("opened fd: %d\n", new_fd);
-  destruct_descriptors_table(&descriptors_table, &superblock);
-  destroy_inode(&inode);
   destroy_super_block(&superblock);
   close(fd);
+  return new_fd;
 }
 
 #endif //EXT_FILESYSTEM_INTERFACE_OPEN_FILE_H_
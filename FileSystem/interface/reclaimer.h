@@ -0,0 +1,158 @@
+/**
+ * @file reclaimer.h
+ * @author yaishenka
+ * @date 19.10.2026
+ * @brief Contains background reclaimer of removed inodes
+ *
+ * remove_path() only marks inodes as orphans. Reclaimer thread releases
+ * them with their blocks when it is woken up, so removing returns
+ * immediately and several removes are reclaimed in one pass.
+ * Image is locked by open_fs_file(), so reclaimer doesn't interleave
+ * with other operations.
+ */
+#ifndef EXT_FILESYSTEM_INTERFACE_RECLAIMER_H_
+#define EXT_FILESYSTEM_INTERFACE_RECLAIMER_H_
+#include <stdlib.h>
+#include <unistd.h>
+#include <stdio.h>
+#include <stdbool.h>
+#include <pthread.h>
+#include "../core/superblock.h"
+#include "../core/defines.h"
+#include "../core/methods.h"
+#include "../core/arena.h"
+#include "../utils.h"
+
+struct reclaimer {
+  const char* path_to_fs_file;
+  pthread_t thread;
+  pthread_mutex_t mutex;
+  pthread_cond_t wakeup;
+  pthread_cond_t idle;
+  bool has_work;
+  bool is_busy;
+  bool stop;
+};
+
+/**
+ * @brief Release orphan inodes and their blocks
+ * @param path_to_fs_file
+ * @return count of released inodes if all ok; -1 if image isn't FS
+ */
+ssize_t reclaim(const char* path_to_fs_file) {
+  int fd = open_fs_file(path_to_fs_file, 0);
+  if (fd == -1) {
+    return -1;
+  }
+
+  struct superblock superblock;
+  if (read_super_block(fd, &superblock) == -1
+      || superblock.fs_info->magic != MAGIC) {
+    destroy_super_block(&superblock);
+    close(fd);
+    return -1;
+  }
+
+  uint16_t reclaimed = reclaim_orphans(fd, &superblock);
+  if (reclaimed != 0 && write_super_block(fd, &superblock) == -1) {
+    fprintf(stderr, "Can't write superblock. Abort!\n");
+    destroy_super_block(&superblock);
+    close(fd);
+    return -1;
+  }
+
+  destroy_super_block(&superblock);
+  close(fd);
+  return reclaimed;
+}
+
+void* reclaimer_loop(void* argument) {
+  struct reclaimer* reclaimer = (struct reclaimer*) argument;
+
+  pthread_mutex_lock(&reclaimer->mutex);
+  while (true) {
+    while (!reclaimer->has_work && !reclaimer->stop) {
+      pthread_cond_wait(&reclaimer->wakeup, &reclaimer->mutex);
+    }
+
+    if (!reclaimer->has_work) {
+      break;
+    }
+
+    reclaimer->has_work = false;
+    reclaimer->is_busy = true;
+    pthread_mutex_unlock(&reclaimer->mutex);
+    reclaim(reclaimer->path_to_fs_file);
+    pthread_mutex_lock(&reclaimer->mutex);
+    reclaimer->is_busy = false;
+    pthread_cond_broadcast(&reclaimer->idle);
+  }
+  pthread_mutex_unlock(&reclaimer->mutex);
+
+  release_arena();
+  return NULL;
+}
+
+/**
+ * @brief Start reclaimer thread
+ * Orphans left by previous run are reclaimed at start
+ * @param reclaimer
+ * @param path_to_fs_file
+ */
+void start_reclaimer(struct reclaimer* reclaimer,
+                     const char* path_to_fs_file) {
+  reclaimer->path_to_fs_file = path_to_fs_file;
+  reclaimer->has_work = access(path_to_fs_file, F_OK) == 0;
+  reclaimer->is_busy = false;
+  reclaimer->stop = false;
+  pthread_mutex_init(&reclaimer->mutex, NULL);
+  pthread_cond_init(&reclaimer->wakeup, NULL);
+  pthread_cond_init(&reclaimer->idle, NULL);
+  if (pthread_create(&reclaimer->thread, NULL, reclaimer_loop, reclaimer)
+      != 0) {
+    fprintf(stderr, "Can't start reclaimer. Abort!\n");
+    exit(EXIT_FAILURE);
+  }
+}
+
+/**
+ * @brief Ask reclaimer to release orphans
+ * @param reclaimer
+ */
+void wake_reclaimer(struct reclaimer* reclaimer) {
+  pthread_mutex_lock(&reclaimer->mutex);
+  reclaimer->has_work = true;
+  pthread_cond_signal(&reclaimer->wakeup);
+  pthread_mutex_unlock(&reclaimer->mutex);
+}
+
+/**
+ * @brief Wait till reclaimer releases all orphans it was asked for
+ * @param reclaimer
+ */
+void wait_reclaimer(struct reclaimer* reclaimer) {
+  pthread_mutex_lock(&reclaimer->mutex);
+  while (reclaimer->has_work || reclaimer->is_busy) {
+    pthread_cond_wait(&reclaimer->idle, &reclaimer->mutex);
+  }
+  pthread_mutex_unlock(&reclaimer->mutex);
+}
+
+/**
+ * @brief Stop reclaimer thread
+ * Pending work is finished before stop
+ * @param reclaimer
+ */
+void stop_reclaimer(struct reclaimer* reclaimer) {
+  pthread_mutex_lock(&reclaimer->mutex);
+  reclaimer->stop = true;
+  pthread_cond_signal(&reclaimer->wakeup);
+  pthread_mutex_unlock(&reclaimer->mutex);
+
+  pthread_join(reclaimer->thread, NULL);
+  pthread_cond_destroy(&reclaimer->wakeup);
+  pthread_cond_destroy(&reclaimer->idle);
+  pthread_mutex_destroy(&reclaimer->mutex);
+}
+
+#endif //EXT_FILESYSTEM_INTERFACE_RECLAIMER_H_
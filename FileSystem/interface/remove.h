@@ -0,0 +1,177 @@
+/**
+ * @file remove.h
+ * @author yaishenka
+ * @date 19.10.2026
+ * @brief Contains method to remove files and directories
+ */
+#ifndef EXT_FILESYSTEM_INTERFACE_REMOVE_H_
+#define EXT_FILESYSTEM_INTERFACE_REMOVE_H_
+#include <stdlib.h>
+#include <unistd.h>
+#include <stdio.h>
+#include <errno.h>
+#include <string.h>
+#include <fcntl.h>
+#include "../core/superblock.h"
+#include "../core/descriptors_table.h"
+#include "../core/defines.h"
+#include "../core/methods.h"
+#include "../utils.h"
+
+#define REMOVE_FILE 0
+#define REMOVE_DIR 1
+#define REMOVE_RECURSIVE 2
+
+/**
+ * @brief Remove file or directory
+ * Removes record from parent directory and marks inode as orphan.
+ * Inode and blocks are released later by reclaim (see reclaimer.h),
+ * so remove doesn't depend on size of file.
+ * REMOVE_FILE removes only files, REMOVE_DIR removes only empty
+ * directories, REMOVE_RECURSIVE removes anything with all its content
+ * @param path_to_fs_file
+ * @param path
+ * @param mode REMOVE_FILE, REMOVE_DIR or REMOVE_RECURSIVE
+ * @return 0 if all ok; -1 otherwise
+ */
+int remove_path(const char* path_to_fs_file, const char* path, int mode) {
+  int fd = open_fs_file(path_to_fs_file, 0);
+  if (fd == -1) {
+    fprintf(stderr, "Can't open file. Abort!\n");
+    exit(EXIT_FAILURE);
+  }
+
+  struct superblock superblock;
+  if (read_super_block(fd, &superblock) == -1
+      || superblock.fs_info->magic != MAGIC) {
+    fprintf(stderr, "Magic does not match. Abort!\n");
+    destroy_super_block(&superblock);
+    close(fd);
+    exit(EXIT_FAILURE);
+  }
+
+  if (!superblock.reserved_inodes_mask[ROOT_INODE_ID]) {
+    fprintf(stderr, "Root directory doesn't exist. Abort!\n");
+    destroy_super_block(&superblock);
+    close(fd);
+    exit(EXIT_FAILURE);
+  }
+
+  char parent_path[buffer_length];
+  char name[buffer_length];
+
+  if (!split_path(path, parent_path, name)
+      || strcmp(name, ".") == 0 || strcmp(name, "..") == 0) {
+    fprintf(stderr, "Incorrect path. Abort!\n");
+    destroy_super_block(&superblock);
+    close(fd);
+    return -1;
+  }
+
+  uint16_t parent_inode_id = get_inode_id_of_dir(fd, parent_path, &superblock);
+  if (parent_inode_id == superblock.fs_info->inodes_count) {
+    fprintf(stderr, "Can't find directory. Abort!\n");
+    destroy_super_block(&superblock);
+    close(fd);
+    return -1;
+  }
+
+  struct inode parent_inode;
+  if (read_inode(fd, &parent_inode, parent_inode_id, &superblock) == -1) {
+    fprintf(stderr, "Can't read inode. Abort!\n");
+    destroy_super_block(&superblock);
+    close(fd);
+    return -1;
+  }
+
+  if (parent_inode.inode_info->is_file) {
+    fprintf(stderr, "Parent is file. Abort!\n");
+    destroy_super_block(&superblock);
+    close(fd);
+    return -1;
+  }
+
+  struct block block;
+  if (read_block(fd, &block, parent_inode.block_ids[0], &superblock) == -1) {
+    fprintf(stderr, "Can't read block. Abort!\n");
+    destroy_super_block(&superblock);
+    close(fd);
+    return -1;
+  }
+
+  uint8_t record_id = 0;
+  for (; record_id < block.block_info->records_count; ++record_id) {
+    if (strcmp(block.block_records[record_id].path, name) == 0) {
+      break;
+    }
+  }
+
+  if (record_id == block.block_info->records_count) {
+    fprintf(stderr, "File doesn't exist. Abort!\n");
+    destroy_super_block(&superblock);
+    close(fd);
+    return -1;
+  }
+
+  uint16_t inode_id = block.block_records[record_id].inode_id;
+  struct inode inode;
+  if (read_inode(fd, &inode, inode_id, &superblock) == -1) {
+    fprintf(stderr, "Can't read inode. Abort!\n");
+    destroy_super_block(&superblock);
+    close(fd);
+    return -1;
+  }
+
+  if (mode == REMOVE_FILE && !inode.inode_info->is_file) {
+    fprintf(stderr, "Is a directory. Abort!\n");
+    destroy_super_block(&superblock);
+    close(fd);
+    return -1;
+  }
+
+  if (mode == REMOVE_DIR && inode.inode_info->is_file) {
+    fprintf(stderr, "Not a directory. Abort!\n");
+    destroy_super_block(&superblock);
+    close(fd);
+    return -1;
+  }
+
+  struct descriptors_table descriptors_table;
+  if (read_descriptors_table(fd, &descriptors_table, &superblock) == -1) {
+    fprintf(stderr, "Can't read descriptors_table. Abort!\n");
+    destroy_super_block(&superblock);
+    close(fd);
+    exit(EXIT_FAILURE);
+  }
+
+  if (!orphan_inode(fd,
+                    &superblock,
+                    &descriptors_table,
+                    inode_id,
+                    mode == REMOVE_RECURSIVE)) {
+    destroy_super_block(&superblock);
+    close(fd);
+    return -1;
+  }
+
+  remove_block_record(&block, record_id);
+  if (!write_directory_block(fd, &superblock, &parent_inode, &block)) {
+    fprintf(stderr, "Can't write block. Abort!\n");
+    destroy_super_block(&superblock);
+    close(fd);
+    exit(EXIT_FAILURE);
+  }
+
+  if (write_super_block(fd, &superblock) == -1) {
+    fprintf(stderr, "Can't write superblock. Abort!\n");
+    destroy_super_block(&superblock);
+    close(fd);
+    exit(EXIT_FAILURE);
+  }
+
+  destroy_super_block(&superblock);
+  close(fd);
+  return 0;
+}
+
+#endif //EXT_FILESYSTEM_INTERFACE_REMOVE_H_
@@ -0,0 +1,170 @@
+/**
+ * @file snapshot.h
+ * @author yaishenka
+ * @date 19.10.2026
+ * @brief Contains methods to take, list, remove and mount snapshots
+ */
+#ifndef EXT_FILESYSTEM_INTERFACE_SNAPSHOT_H_
+#define EXT_FILESYSTEM_INTERFACE_SNAPSHOT_H_
+#include <stdlib.h>
+#include <unistd.h>
+#include <stdio.h>
+#include <errno.h>
+#include <string.h>
+#include <fcntl.h>
+#include "../core/superblock.h"
+#include "../core/defines.h"
+#include "../core/snapshot.h"
+#include "../utils.h"
+
+/**
+ * @brief Take snapshot of FS
+ * Blocks of files are shared with snapshot, only inodes table is copied
+ * @param path_to_fs_file
+ * @param name
+ * @return count of blocks used by snapshot if all ok; -1 otherwise
+ */
+ssize_t snapshot(const char* path_to_fs_file, const char* name) {
+  int fd = open_fs_file(path_to_fs_file, 0);
+  if (fd == -1) {
+    fprintf(stderr, "Can't open file. Abort!\n");
+    exit(EXIT_FAILURE);
+  }
+
+  struct superblock superblock;
+  if (read_super_block(fd, &superblock) == -1
+      || superblock.fs_info->magic != MAGIC) {
+    fprintf(stderr, "Magic does not match. Abort!\n");
+    destroy_super_block(&superblock);
+    close(fd);
+    exit(EXIT_FAILURE);
+  }
+
+  if (!superblock.reserved_inodes_mask[ROOT_INODE_ID]) {
+    fprintf(stderr, "Root directory doesn't exist. Abort!\n");
+    destroy_super_block(&superblock);
+    close(fd);
+    exit(EXIT_FAILURE);
+  }
+
+  ssize_t blocks_count = create_snapshot(fd, &superblock, name);
+  if (blocks_count != -1 && write_super_block(fd, &superblock) == -1) {
+    fprintf(stderr, "Can't write superblock. Abort!\n");
+    destroy_super_block(&superblock);
+    close(fd);
+    exit(EXIT_FAILURE);
+  }
+
+  destroy_super_block(&superblock);
+  close(fd);
+  return blocks_count;
+}
+
+/**
+ * @brief Remove snapshot
+ * Blocks which are referenced only by snapshot are released
+ * @param path_to_fs_file
+ * @param name
+ * @return 0 if all ok; -1 otherwise
+ */
+int remove_snapshot(const char* path_to_fs_file, const char* name) {
+  int fd = open_fs_file(path_to_fs_file, 0);
+  if (fd == -1) {
+    fprintf(stderr, "Can't open file. Abort!\n");
+    exit(EXIT_FAILURE);
+  }
+
+  struct superblock superblock;
+  if (read_super_block(fd, &superblock) == -1
+      || superblock.fs_info->magic != MAGIC) {
+    fprintf(stderr, "Magic does not match. Abort!\n");
+    destroy_super_block(&superblock);
+    close(fd);
+    exit(EXIT_FAILURE);
+  }
+
+  if (!delete_snapshot(fd, &superblock, name)) {
+    destroy_super_block(&superblock);
+    close(fd);
+    return -1;
+  }
+
+  if (write_super_block(fd, &superblock) == -1) {
+    fprintf(stderr, "Can't write superblock. Abort!\n");
+    destroy_super_block(&superblock);
+    close(fd);
+    exit(EXIT_FAILURE);
+  }
+
+  destroy_super_block(&superblock);
+  close(fd);
+  return 0;
+}
+
+/**
+ * @brief Print names of snapshots
+ * @param path_to_fs_file
+ */
+void list_snapshots(const char* path_to_fs_file) {
+  int fd = open_fs_file(path_to_fs_file, 0);
+  if (fd == -1) {
+    fprintf(stderr, "Can't open file. Abort!\n");
+    exit(EXIT_FAILURE);
+  }
+
+  struct superblock superblock;
+  if (read_super_block(fd, &superblock) == -1
+      || superblock.fs_info->magic != MAGIC) {
+    fprintf(stderr, "Magic does not match. Abort!\n");
+    destroy_super_block(&superblock);
+    close(fd);
+    exit(EXIT_FAILURE);
+  }
+
+  for (uint16_t i = 0; i < SNAPSHOTS_COUNT; ++i) {
+    const struct snapshot_info* snapshot = &superblock.snapshots[i];
+    if (snapshot->blocks_count != 0) {
+      printf("%.*s -- %u blocks\n",
+             MAX_PATH_LEN,
+             snapshot->name,
+             snapshot->blocks_count);
+    }
+  }
+
+  destroy_super_block(&superblock);
+  close(fd);
+}
+
+/**
+ * @brief Mount snapshot read-only
+ * Next commands see snapshot instead of current FS
+ * @param path_to_fs_file
+ * @param name name of snapshot; NULL to mount current FS
+ * @return 0 if all ok; -1 otherwise
+ */
+int mount(const char* path_to_fs_file, const char* name) {
+  mount_snapshot(name);
+  if (name == NULL) {
+    return 0;
+  }
+
+  int fd = open_fs_file(path_to_fs_file, 0);
+  if (fd == -1) {
+    fprintf(stderr, "Can't open file. Abort!\n");
+    exit(EXIT_FAILURE);
+  }
+
+  struct superblock superblock;
+  int result = 0;
+  if (read_super_block(fd, &superblock) == -1
+      || superblock.fs_info->magic != MAGIC) {
+    mount_snapshot(NULL);
+    result = -1;
+  }
+
+  destroy_super_block(&superblock);
+  close(fd);
+  return result;
+}
+
+#endif //EXT_FILESYSTEM_INTERFACE_SNAPSHOT_H_
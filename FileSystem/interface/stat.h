@@ -0,0 +1,120 @@
+/**
+ * @file stat.h
+ * @author yaishenka
+ * @date 19.10.2026
+ * @brief Contains method to get information about file
+ */
+#ifndef EXT_FILESYSTEM_INTERFACE_STAT_H_
+#define EXT_FILESYSTEM_INTERFACE_STAT_H_
+#include <stdlib.h>
+#include <unistd.h>
+#include <stdio.h>
+#include <string.h>
+#include <fcntl.h>
+#include "../core/superblock.h"
+#include "../core/inode.h"
+#include "../core/defines.h"
+#include "../core/methods.h"
+#include "../core/file.h"
+#include "../utils.h"
+
+/**
+ * @brief Information about file or directory
+ * blocks_count is count of blocks addressed by inode (0 for inline file),
+ * every block of clusters is counted
+ */
+struct file_stat {
+  uint16_t inode_id;
+  bool is_file;
+  uint64_t size;
+  uint16_t blocks_count;
+  uint64_t modified_time;
+};
+
+/**
+ * @brief Get information about file or directory
+ * Everything is taken from inode: blocks of file aren't read
+ * @param path_to_fs_file
+ * @param path
+ * @param file_stat
+ * @return 0 if all ok; -1 otherwise
+ */
+int stat_file(const char* path_to_fs_file,
+              const char* path,
+              struct file_stat* file_stat) {
+  int fd = open_fs_file(path_to_fs_file, 0);
+  if (fd == -1) {
+    fprintf(stderr, "Can't open file. Abort!\n");
+    exit(EXIT_FAILURE);
+  }
+
+  struct superblock superblock;
+  if (read_super_block(fd, &superblock) == -1
+      || superblock.fs_info->magic != MAGIC) {
+    fprintf(stderr, "Magic does not match. Abort!\n");
+    destroy_super_block(&superblock);
+    close(fd);
+    exit(EXIT_FAILURE);
+  }
+
+  if (!superblock.reserved_inodes_mask[ROOT_INODE_ID]) {
+    fprintf(stderr, "Root directory doesn't exist. Abort!\n");
+    destroy_super_block(&superblock);
+    close(fd);
+    exit(EXIT_FAILURE);
+  }
+
+  uint16_t inode_id = ROOT_INODE_ID;
+  struct inode inode;
+  if (strcmp(path, "/") != 0) {
+    char parent_path[buffer_length];
+    char name[buffer_length];
+    if (!split_path(path, parent_path, name)) {
+      fprintf(stderr, "Incorrect path. Abort!\n");
+      destroy_super_block(&superblock);
+      close(fd);
+      return -1;
+    }
+
+    uint16_t parent_id = get_inode_id_of_dir(fd, parent_path, &superblock);
+    if (parent_id == superblock.fs_info->inodes_count
+        || read_inode(fd, &inode, parent_id, &superblock) == -1
+        || inode.inode_info->is_file) {
+      fprintf(stderr, "Can't find directory. Abort!\n");
+      destroy_super_block(&superblock);
+      close(fd);
+      return -1;
+    }
+
+    inode_id = get_file_inode_id(fd, &inode, name, &superblock);
+    if (inode_id == superblock.fs_info->inodes_count) {
+      fprintf(stderr, "File doesn't exist. Abort!\n");
+      destroy_super_block(&superblock);
+      close(fd);
+      return -1;
+    }
+  }
+
+  if (read_inode(fd, &inode, inode_id, &superblock) == -1) {
+    fprintf(stderr, "Can't read inode. Abort!\n");
+    destroy_super_block(&superblock);
+    close(fd);
+    return -1;
+  }
+
+  file_stat->inode_id = inode_id;
+  file_stat->is_file = inode.inode_info->is_file;
+  file_stat->size = get_inode_data_size(&inode);
+  file_stat->blocks_count = 0;
+  if (!is_inline_inode(&inode)) {
+    file_stat->blocks_count = inode.inode_info->blocks_count
+        * get_inode_cluster_size(&inode, &superblock);
+  }
+  file_stat->modified_time = inode.inode_info->modified_time;
+
+  destroy_super_block(&superblock);
+  close(fd);
+  return 0;
+}
+
+#endif //EXT_FILESYSTEM_INTERFACE_STAT_H_
@@ -1,11 +1,29 @@
 /** @author yaishenka
     @date 10.03.2021 */
+#define _GNU_SOURCE
 #include <string.h>
 #include <stdio.h>
 #include <sys/stat.h>
+#include <sys/file.h>
 #include <fcntl.h>
 #include <unistd.h>
+#include <errno.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+#if defined(__x86_64__) || defined(__i386__)
+#include <nmmintrin.h>
+#endif
 #include "utils.h"
+#include "core/arena.h"
+#include "core/defines.h"
+
+/**
+ * Set by main thread and read by reclaimer thread too, so it is atomic
+ */
+static atomic_bool direct_io = false;
 
 int read_while(const int fd, char* buffer, size_t to_read) {
   size_t total = 0;
@@ -38,6 +56,277 @@ int write_while(const int fd, const char* buffer, size_t to_write) {
   return total;
 }
 
+void set_direct_io(bool enabled) {
+  atomic_store(&direct_io, enabled);
+}
+
+int open_unlocked_fs_file(const char* path_to_fs_file, int flags) {
+  if (atomic_load(&direct_io)) {
+    int fd = open(path_to_fs_file,
+                  O_RDWR | O_CREAT | O_DIRECT | flags,
+                  S_IRUSR | S_IWUSR);
+    if (fd != -1 || errno != EINVAL) {
+      return fd;
+    }
+
+    fprintf(stderr, "O_DIRECT is not supported. Direct I/O is off!\n");
+    atomic_store(&direct_io, false);
+  }
+
+  return open(path_to_fs_file, O_RDWR | O_CREAT | flags, S_IRUSR | S_IWUSR);
+}
+
+int open_fs_file(const char* path_to_fs_file, int flags) {
+  int fd = open_unlocked_fs_file(path_to_fs_file, flags & ~O_TRUNC);
+  if (fd == -1) {
+    return -1;
+  }
+
+  while (flock(fd, LOCK_EX) == -1) {
+    if (errno != EINTR) {
+      fprintf(stderr, "%s\n", strerror(errno));
+      close(fd);
+      return -1;
+    }
+  }
+
+  if ((flags & O_TRUNC) && ftruncate(fd, 0) == -1) {
+    fprintf(stderr, "%s\n", strerror(errno));
+    close(fd);
+    return -1;
+  }
+
+  return fd;
+}
+
+int open_read_only_fs_file(const char* path_to_fs_file) {
+  int fd = open(path_to_fs_file, O_RDONLY);
+  if (fd == -1) {
+    fprintf(stderr, "%s\n", strerror(errno));
+    return -1;
+  }
+
+  while (flock(fd, LOCK_SH) == -1) {
+    if (errno != EINTR) {
+      fprintf(stderr, "%s\n", strerror(errno));
+      close(fd);
+      return -1;
+    }
+  }
+
+  return fd;
+}
+
+int punch_hole(const int fd, off_t offset, off_t length) {
+  return fallocate(fd,
+                   FALLOC_FL_PUNCH_HOLE | FALLOC_FL_KEEP_SIZE,
+                   offset,
+                   length);
+}
+
+bool is_aligned_request(const char* buffer, size_t size, off_t offset) {
+  return (uintptr_t) buffer % IMAGE_ALIGNMENT == 0
+      && size % IMAGE_ALIGNMENT == 0
+      && offset % IMAGE_ALIGNMENT == 0;
+}
+
+ssize_t pread_all(const int fd, char* buffer, size_t to_read, off_t offset) {
+  size_t total = 0;
+
+  while (total != to_read) {
+    ssize_t readed = pread(fd, buffer + total, to_read - total, offset + total);
+    if (readed == -1) {
+      return readed;
+    }
+
+    total += readed;
+
+    if (readed == 0 || (atomic_load(&direct_io) && total != to_read)) {
+      memset(buffer + total, 0, to_read - total);
+      break;
+    }
+  }
+
+  return to_read;
+}
+
+ssize_t pwrite_all(const int fd,
+                   const char* buffer,
+                   size_t to_write,
+                   off_t offset) {
+  size_t total = 0;
+
+  while (total != to_write) {
+    ssize_t written =
+        pwrite(fd, buffer + total, to_write - total, offset + total);
+
+    if (written == -1) {
+      return written;
+    }
+
+    total += written;
+  }
+
+  return total;
+}
+
+ssize_t pread_while(const int fd, char* buffer, size_t to_read, off_t offset) {
+  if (!atomic_load(&direct_io)
+      || is_aligned_request(buffer, to_read, offset)) {
+    return pread_all(fd, buffer, to_read, offset);
+  }
+
+  off_t begin = offset - offset % IMAGE_ALIGNMENT;
+  off_t end = offset + to_read;
+  end += (IMAGE_ALIGNMENT - end % IMAGE_ALIGNMENT) % IMAGE_ALIGNMENT;
+
+  char* aligned = (char*) arena_aligned_calloc(end - begin,
+                                               sizeof(char),
+                                               IMAGE_ALIGNMENT);
+  if (pread_all(fd, aligned, end - begin, begin) == -1) {
+    return -1;
+  }
+
+  memcpy(buffer, aligned + (offset - begin), to_read);
+  return to_read;
+}
+
+ssize_t pwrite_while(const int fd,
+                     const char* buffer,
+                     size_t to_write,
+                     off_t offset) {
+  if (!atomic_load(&direct_io)
+      || is_aligned_request(buffer, to_write, offset)) {
+    return pwrite_all(fd, buffer, to_write, offset);
+  }
+
+  off_t begin = offset - offset % IMAGE_ALIGNMENT;
+  off_t end = offset + to_write;
+  end += (IMAGE_ALIGNMENT - end % IMAGE_ALIGNMENT) % IMAGE_ALIGNMENT;
+
+  char* aligned = (char*) arena_aligned_calloc(end - begin,
+                                               sizeof(char),
+                                               IMAGE_ALIGNMENT);
+  if (pread_all(fd, aligned, end - begin, begin) == -1) {
+    return -1;
+  }
+
+  memcpy(aligned + (offset - begin), buffer, to_write);
+  if (pwrite_all(fd, aligned, end - begin, begin) == -1) {
+    return -1;
+  }
+
+  return to_write;
+}
+
+bool is_zero_memory(const char* data, size_t size) {
+  size_t position = 0;
+
+#if defined(__SSE2__)
+  const __m128i zero = _mm_setzero_si128();
+  for (; position + 4 * sizeof(__m128i) <= size;
+       position += 4 * sizeof(__m128i)) {
+    const __m128i* chunk = (const __m128i*) (data + position);
+    __m128i accumulator = _mm_or_si128(
+        _mm_or_si128(_mm_loadu_si128(chunk), _mm_loadu_si128(chunk + 1)),
+        _mm_or_si128(_mm_loadu_si128(chunk + 2), _mm_loadu_si128(chunk + 3)));
+    if (_mm_movemask_epi8(_mm_cmpeq_epi8(accumulator, zero)) != 0xFFFF) {
+      return false;
+    }
+  }
+#endif
+
+  for (; position + sizeof(uint64_t) <= size; position += sizeof(uint64_t)) {
+    uint64_t word;
+    memcpy(&word, data + position, sizeof(uint64_t));
+    if (word != 0) {
+      return false;
+    }
+  }
+
+  for (; position < size; ++position) {
+    if (data[position] != 0) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+#define CRC32C_POLYNOMIAL 0x82F63B78
+
+static uint32_t crc32c_table[256];
+static pthread_once_t crc32c_table_once = PTHREAD_ONCE_INIT;
+
+void init_crc32c_table(void) {
+  for (uint32_t byte = 0; byte < 256; ++byte) {
+    uint32_t crc = byte;
+    for (int bit = 0; bit < 8; ++bit) {
+      crc = (crc >> 1) ^ (crc & 1 ? CRC32C_POLYNOMIAL : 0);
+    }
+    crc32c_table[byte] = crc;
+  }
+}
+
+uint32_t crc32c_software(uint32_t crc, const char* data, size_t size) {
+  pthread_once(&crc32c_table_once, init_crc32c_table);
+  for (size_t position = 0; position < size; ++position) {
+    crc = crc32c_table[(crc ^ (uint8_t) data[position]) & 0xFF] ^ (crc >> 8);
+  }
+  return crc;
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+__attribute__((target("sse4.2")))
+uint32_t crc32c_hardware(uint32_t crc, const char* data, size_t size) {
+  size_t position = 0;
+
+#if defined(__x86_64__)
+  uint64_t wide_crc = crc;
+  for (; position + sizeof(uint64_t) <= size; position += sizeof(uint64_t)) {
+    uint64_t word;
+    memcpy(&word, data + position, sizeof(uint64_t));
+    wide_crc = _mm_crc32_u64(wide_crc, word);
+  }
+  crc = (uint32_t) wide_crc;
+#endif
+
+  for (; position < size; ++position) {
+    crc = _mm_crc32_u8(crc, (uint8_t) data[position]);
+  }
+  return crc;
+}
+#endif
+
+uint32_t crc32c(uint32_t crc, const char* data, size_t size) {
+  crc = ~crc;
+#if defined(__x86_64__) || defined(__i386__)
+  if (__builtin_cpu_supports("sse4.2")) {
+    return ~crc32c_hardware(crc, data, size);
+  }
+#endif
+  return ~crc32c_software(crc, data, size);
+}
+
+uint32_t get_record_checksum(const char* record, size_t size) {
+  return crc32c(0, record + sizeof(uint32_t), size - sizeof(uint32_t));
+}
+
+void set_record_checksum(char* record, size_t size) {
+  uint32_t checksum = get_record_checksum(record, size);
+  memcpy(record, &checksum, sizeof(uint32_t));
+}
+
+bool is_record_checksum_valid(const char* record, size_t size) {
+  uint32_t checksum;
+  memcpy(&checksum, record, sizeof(uint32_t));
+  if (checksum == get_record_checksum(record, size)) {
+    return true;
+  }
+
+  return checksum == 0 && is_zero_memory(record, size);
+}
+
 char* parse_path(const char* path, char* current_file_name) {
   if (strcmp(path, "/") == 0) {
     strcpy(current_file_name, "/");
@@ -74,7 +363,11 @@ char* parse_path(const char* path, char* current_file_name) {
 }
 
 bool split_path(const char* path, char* parent_path, char* dirname) {
-  uint16_t path_length = strlen(path);
+  size_t path_length = strlen(path);
+  if (path_length == 0 || path_length >= buffer_length) {
+    fprintf(stderr, "Incorrect path to split. Abort!\n");
+    return false;
+  }
 
   char buffer[buffer_length];
   memcpy(buffer, path, path_length);
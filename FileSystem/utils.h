@@ -31,6 +31,105 @@ int read_while(int fd, char* buffer, size_t to_read);
  */
 int write_while(int fd, const char* buffer, size_t to_write);
 
+/**
+ * @brief Enable or disable direct I/O for FS files
+ * Files opened with open_fs_file after this call bypass page cache (O_DIRECT)
+ * @param enabled
+ */
+void set_direct_io(bool enabled);
+
+/**
+ * @brief Open FS file
+ * Opens file with O_RDWR | O_CREAT | flags and O_DIRECT if direct I/O is on.
+ * If file system doesn't support O_DIRECT, direct I/O is turned off.
+ * File is exclusively locked (flock) till fd is closed, so operations of
+ * different threads and processes don't interleave.
+ * O_TRUNC is applied after lock is taken
+ * @param path_to_fs_file
+ * @param flags additional flags for open
+ * @return fd if all ok; -1 otherwise
+ */
+int open_fs_file(const char* path_to_fs_file, int flags);
+
+/**
+ * @brief Open existing FS file for reading only
+ * File is locked with shared flock, so it can be read by several
+ * operations at once but isn't changed while fd is opened
+ * @param path_to_fs_file
+ * @return fd if all ok; -1 otherwise
+ */
+int open_read_only_fs_file(const char* path_to_fs_file);
+
+/**
+ * @brief Deallocate range of file on host file system
+ * Range is read as zeros after that. Size of file isn't changed
+ * @param fd
+ * @param offset
+ * @param length
+ * @return 0 if all ok; -1 otherwise (e.g. host FS can't punch holes)
+ */
+int punch_hole(int fd, off_t offset, off_t length);
+
+/**
+ * @brief Properly reading from memory at offset
+ * Bytes after end of file are read as zeros.
+ * In direct I/O mode unaligned requests go through aligned buffer
+ * @param fd
+ * @param buffer
+ * @param to_read
+ * @param offset
+ * @return to_read if all ok; -1 otherwise
+ */
+ssize_t pread_while(int fd, char* buffer, size_t to_read, off_t offset);
+
+/**
+ * @brief Properly writing to memory at offset
+ * In direct I/O mode unaligned requests are read-modify-written
+ * through aligned buffer
+ * @param fd
+ * @param buffer
+ * @param to_write
+ * @param offset
+ * @return to_write if all ok; -1 otherwise
+ */
+ssize_t pwrite_while(int fd, const char* buffer, size_t to_write, off_t offset);
+
+/**
+ * @brief Check if memory contains only zeros
+ * Uses SSE2 if it is available
+ * @param data
+ * @param size
+ * @return true if all bytes are zero
+ */
+bool is_zero_memory(const char* data, size_t size);
+
+/**
+ * @brief Count CRC32C of data
+ * Uses SSE4.2 crc32 instruction if CPU supports it, table otherwise
+ * @param crc CRC32C of previous data or 0
+ * @param data
+ * @param size
+ * @return CRC32C
+ */
+uint32_t crc32c(uint32_t crc, const char* data, size_t size);
+
+/**
+ * @brief Store checksum of on-disk record in its first uint32_t
+ * Checksum covers the rest of record
+ * @param record
+ * @param size
+ */
+void set_record_checksum(char* record, size_t size);
+
+/**
+ * @brief Verify checksum stored by set_record_checksum()
+ * Zero record is valid: it is never written part of sparse image
+ * @param record
+ * @param size
+ * @return true if checksum matches
+ */
+bool is_record_checksum_valid(const char* record, size_t size);
+
 /**
  * @brief Parse path
  * @param path
@@ -3,8 +3,15 @@
 #include <stdlib.h>
 #include <string.h>
 #include "FileSystem/interface/client.h"
+#include "FileSystem/utils.h"
+
+#define DIRECT "direct"
 
 int main(int argc, char** argv) {
+  if (argc > 2 && strcmp(argv[2], DIRECT) == 0) {
+    set_direct_io(true);
+  }
+
   if (argc < 2) {
     fprintf(stderr, "Path to fs file wasn't specified. Using default name!\n");
     const char* fs_file_path = "test_fs";
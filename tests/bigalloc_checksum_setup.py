@@ -0,0 +1,30 @@
+"""Create bigalloc image and damage second block of clusters of /f and /g.
+
+Both files are written from host files and are long enough to use clusters.
+/g is shared with snapshot, so its whole cluster is copied before write.
+Damaged bytes are found by content, so test doesn't depend on layout.
+"""
+import subprocess
+import sys
+
+BLOCKS = 10
+MARKERS = {b"f": b"damaged-f-block", b"g": b"damaged-g-block"}
+
+for name, marker in MARKERS.items():
+    with open(name.decode() + ".bin", "wb") as file:
+        for index in range(BLOCKS):
+            block = marker if index == 1 else name + b"-block-%02d" % index
+            file.write(block.ljust(128, b"."))
+
+subprocess.run([sys.argv[1], "test_fs"], check=True, stdout=subprocess.DEVNULL,
+               input=b"init bigalloc\ntouch /g\nopen /g\nwrite_from 0 g.bin\n"
+               + b"close 0\nsnapshot s1\ntouch /f\nopen /f\n"
+               + b"write_from 0 f.bin\nclose 0\nquit\n")
+
+with open("test_fs", "r+b") as image:
+    content = bytearray(image.read())
+    for marker in MARKERS.values():
+        position = content.index(marker)
+        content[position] ^= 0xFF
+    image.seek(0)
+    image.write(content)
@@ -0,0 +1,22 @@
+"""Create image and damage data block of /f and directory block of /d.
+
+Damaged bytes are found by content, so test doesn't depend on layout.
+"""
+import subprocess
+import sys
+
+DATA = b"checksummed-file-data"
+NAME = b"child"
+
+subprocess.run([sys.argv[1], "test_fs"], check=True, stdout=subprocess.DEVNULL,
+               input=b"init\nmkdir /d\ntouch /d/" + NAME + b"\ntouch /f\nopen /f\n"
+               + b"write 0 " + DATA + b"\nclose 0\ntouch /g\nopen /g\n"
+               + b"write 0 intact\nclose 0\nquit\n")
+
+with open("test_fs", "r+b") as image:
+    content = bytearray(image.read())
+    for pattern in (DATA, NAME):
+        position = content.index(pattern)
+        content[position] ^= 0xFF
+    image.seek(0)
+    image.write(content)
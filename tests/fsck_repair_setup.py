@@ -0,0 +1,44 @@
+"""Create image and damage its superblock for fsck_repair test.
+
+Reserved bit of inode of /d/f is cleared, so record of /d points to free
+inode, and last block is marked reserved, so it is leaked.
+"""
+import struct
+import subprocess
+import sys
+
+FS_INFO = "<IHHHHHHHHH"
+SNAPSHOT_INFO_SIZE = 16 + 4
+SNAPSHOTS_COUNT = 8
+FILE_INODE_ID = 2
+
+
+def crc32c(data):
+    crc = 0xFFFFFFFF
+    for byte in data:
+        crc ^= byte
+        for _ in range(8):
+            crc = (crc >> 1) ^ (0x82F63B78 if crc & 1 else 0)
+    return crc ^ 0xFFFFFFFF
+
+
+subprocess.run([sys.argv[1], "test_fs"], check=True, stdout=subprocess.DEVNULL,
+               input=b"init\nmkdir /d\ntouch /d/f\ntouch /g\nquit\n")
+
+with open("test_fs", "r+b") as image:
+    fs_info_size = struct.calcsize(FS_INFO)
+    fs_info = struct.unpack(FS_INFO, image.read(fs_info_size))
+    inodes_count, blocks_count = fs_info[1], fs_info[2]
+    size = (fs_info_size + 2 * inodes_count + 3 * blocks_count
+            + SNAPSHOT_INFO_SIZE * SNAPSHOTS_COUNT)
+
+    image.seek(0)
+    record = bytearray(image.read(size))
+    reserved_inodes_mask = fs_info_size
+    reserved_blocks_mask = reserved_inodes_mask + inodes_count
+    record[reserved_inodes_mask + FILE_INODE_ID] = 0
+    record[reserved_blocks_mask + blocks_count - 1] = 1
+    record[0:4] = struct.pack("<I", crc32c(record[4:]))
+
+    image.seek(0)
+    image.write(record)
@@ -0,0 +1,10 @@
+"""Create overlay of base image, then init base again with other geometry."""
+import subprocess
+import sys
+
+subprocess.run([sys.argv[1], "base"], check=True, stdout=subprocess.DEVNULL,
+               input=b"init\ntouch /f\nquit\n")
+subprocess.run([sys.argv[1], "test_fs"], check=True, stdout=subprocess.DEVNULL,
+               input=b"overlay base\ntouch /g\nquit\n")
+subprocess.run([sys.argv[1], "base"], check=True, stdout=subprocess.DEVNULL,
+               input=b"init 32 8\nquit\n")
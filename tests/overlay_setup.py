@@ -0,0 +1,7 @@
+"""Create base image for overlay test."""
+import subprocess
+import sys
+
+subprocess.run([sys.argv[1], "base"], check=True, stdout=subprocess.DEVNULL,
+               input=b"init\nmkdir /d\ntouch /d/f\nopen /d/f\n"
+               b"write 0 base-data\nclose 0\ntouch /g\nquit\n")
@@ -0,0 +1,54 @@
+"""Run commands of test through client and compare output with expected one.
+
+Usage: run_test.py path_to_ext path_to_test
+
+path_to_test is tests/<name> without suffix: tests/<name>_commands are fed
+to client on fresh image, its stdout must be equal to tests/<name>_expected
+byte to byte (batch tests have binary requests and responses).
+Client runs in temporary directory, so host files of commands
+(read_to, write_from) are relative to it. If tests/<name>_setup.py exists,
+it is run in that directory first (with path_to_ext as argument) to prepare
+test_fs, for example to damage image for fsck. If tests/<name>_args exists,
+its words are passed to client after test_fs (for example direct).
+Time printed by stat is replaced with <time> before comparison.
+"""
+import difflib
+import os
+import re
+import subprocess
+import sys
+import tempfile
+
+if len(sys.argv) != 3:
+    sys.stderr.write("Usage: {0} path_to_ext path_to_test\n".format(sys.argv[0]))
+    sys.exit(2)
+
+ext, test = os.path.abspath(sys.argv[1]), sys.argv[2]
+
+with open(test + "_commands", "rb") as file:
+    commands = file.read()
+with open(test + "_expected", "rb") as file:
+    expected = file.read()
+args = []
+if os.path.exists(test + "_args"):
+    with open(test + "_args") as file:
+        args = file.read().split()
+
+with tempfile.TemporaryDirectory() as directory:
+    if os.path.exists(test + "_setup.py"):
+        subprocess.run([sys.executable, os.path.abspath(test + "_setup.py"), ext],
+                       cwd=directory, check=True, timeout=60)
+    result = subprocess.run([ext, "test_fs"] + args, input=commands, cwd=directory,
+                            stdout=subprocess.PIPE, stderr=subprocess.PIPE,
+                            timeout=60)
+
+output = re.sub(rb"^Modified: .*$", b"Modified: <time>", result.stdout,
+                flags=re.M)
+if result.returncode != 0 or output != expected:
+    sys.stderr.write(result.stderr.decode(errors="replace"))
+    sys.stderr.writelines(difflib.unified_diff(
+        expected.decode(errors="replace").splitlines(True),
+        output.decode(errors="replace").splitlines(True),
+        "expected", "output"))
+    sys.stderr.write("Exit code: {0}\n".format(result.returncode))
+    sys.exit(1)